@@ -0,0 +1,242 @@
+#include "Adjustment.hpp"
+#include "Aggregation.hpp"
+#include <cmath>
+#include <fstream>
+#include <iostream>
+
+namespace
+{
+    using StockData::BarArchiveDay;
+    using StockData::Bars;
+    using StockData::DataFrequency;
+
+    /// @brief Split bars whose times carry the date into days: daily bars are timed YYYYMMDD, intraday ones YYYYMMDDHHMMSS
+    /// @return false if intraday bar times are not dates, e.g. the per-day times of a .1m.bars file
+    bool GetDays(const Bars& bars, std::vector<BarArchiveDay>& days)
+    {
+        days.clear();
+        const bool daily = bars.frequency == DataFrequency::Bar1d;
+        for (size_t i = 0; i < bars.data.size(); ++i)
+        {
+            uint64_t time = bars.data[i].time;
+            if (!daily && !StockData::HasBarDate(time))
+            {
+                days.clear();
+                return false;
+            }
+            uint64_t date = daily ? time : StockData::GetBarDate(time);
+            if (days.empty() || days.back().date != date)
+            {
+                days.push_back(BarArchiveDay{date, i, 0});
+            }
+            ++days.back().barCount;
+        }
+        return true;
+    }
+
+    bool ParseFactorLine(const std::string& line, std::string& symbol, uint64_t& exDate, double& ratio)
+    {
+        size_t firstComma = line.find(',');
+        size_t secondComma = firstComma == std::string::npos ? std::string::npos : line.find(',', firstComma + 1);
+        if (secondComma == std::string::npos)
+        {
+            return false;
+        }
+
+        symbol = line.substr(0, firstComma);
+        const char* dateBegin = line.c_str() + firstComma + 1;
+        const char* ratioBegin = line.c_str() + secondComma + 1;
+        char* end;
+        exDate = strtoull(dateBegin, &end, 10);
+        if (end == dateBegin || end != line.c_str() + secondComma)
+        {
+            return false;
+        }
+        ratio = strtod(ratioBegin, &end);
+        while (*end == ' ' || *end == '\r')
+        {
+            ++end;
+        }
+        return end != ratioBegin && *end == '\0';
+    }
+}
+
+double StockData::SymbolFactors::GetFactor(uint64_t date, AdjustmentMode mode) const
+{
+    size_t applied = std::upper_bound(exDates.begin(), exDates.end(), date) - exDates.begin();
+    double backward = applied > 0 ? cumulative[applied - 1] : 1.0;
+    if (mode == AdjustmentMode::Backward || cumulative.empty())
+    {
+        return backward;
+    }
+    return backward / cumulative.back();
+}
+
+bool StockData::AdjustmentFactors::Load(const std::string &filePath, std::string &error)
+{
+    std::ifstream file(filePath);
+    if (!file.is_open())
+    {
+        error = "Failed to open file: " + filePath;
+        return false;
+    }
+
+    std::string line;
+    for (size_t lineNumber = 1; std::getline(file, line); ++lineNumber)
+    {
+        if (line.empty() || line[0] == '#' || line == "\r")
+        {
+            continue;
+        }
+        std::string symbol;
+        uint64_t exDate;
+        double ratio;
+        if (!ParseFactorLine(line, symbol, exDate, ratio) || !AddEvent(symbol, exDate, ratio))
+        {
+            error = "Malformed factor line " + std::to_string(lineNumber) + " in " + filePath + ": " + line;
+            return false;
+        }
+    }
+    return true;
+}
+
+bool StockData::AdjustmentFactors::AddEvent(const std::string &symbol, uint64_t exDate, double ratio)
+{
+    if (!(ratio > 0.0) || !std::isfinite(ratio))
+    {
+        return false;
+    }
+
+    SymbolFactors& factors = symbols[symbol];
+    size_t position = std::upper_bound(factors.exDates.begin(), factors.exDates.end(), exDate) - factors.exDates.begin();
+    factors.exDates.insert(factors.exDates.begin() + position, exDate);
+    factors.ratios.insert(factors.ratios.begin() + position, ratio);
+
+    factors.cumulative.resize(factors.ratios.size());
+    for (size_t k = position; k < factors.ratios.size(); ++k)
+    {
+        factors.cumulative[k] = (k > 0 ? factors.cumulative[k - 1] : 1.0) * factors.ratios[k];
+    }
+    return true;
+}
+
+const StockData::SymbolFactors *StockData::AdjustmentFactors::Find(const std::string &symbol) const
+{
+    auto it = symbols.find(symbol);
+    return it != symbols.end() ? &it->second : nullptr;
+}
+
+StockData::AdjustedBarsView::AdjustedBarsView(const Bars &unadjusted, const SymbolFactors *symbolFactors, AdjustmentMode adjustmentMode)
+    : bars(&unadjusted), mode(adjustmentMode)
+{
+    std::vector<BarArchiveDay> days;
+    if (!GetDays(unadjusted, days))
+    {
+        std::cerr << "Bar times of " << unadjusted.symbol.c_str() << " are not dates, pass the date of the bars to adjust them\n";
+        symbolFactors = nullptr;
+    }
+    BuildSegments(days, symbolFactors);
+}
+
+StockData::AdjustedBarsView::AdjustedBarsView(const Bars &unadjusted, const AdjustmentFactors &allFactors, AdjustmentMode adjustmentMode)
+    : AdjustedBarsView(unadjusted, allFactors.Find(std::string(unadjusted.symbol.c_str())), adjustmentMode) // ReadBars leaves a null terminator in symbol
+{}
+
+StockData::AdjustedBarsView::AdjustedBarsView(const Bars &unadjusted, uint64_t date, const SymbolFactors *symbolFactors, AdjustmentMode adjustmentMode)
+    : bars(&unadjusted), mode(adjustmentMode)
+{
+    BuildSegments({BarArchiveDay{date, 0, unadjusted.data.size()}}, symbolFactors);
+}
+
+StockData::AdjustedBarsView::AdjustedBarsView(const Bars &unadjusted, const std::vector<BarArchiveDay> &days, const SymbolFactors *symbolFactors, AdjustmentMode adjustmentMode)
+    : bars(&unadjusted), mode(adjustmentMode)
+{
+    BuildSegments(days, symbolFactors);
+}
+
+void StockData::AdjustedBarsView::BuildSegments(const std::vector<BarArchiveDay> &days, const SymbolFactors *symbolFactors)
+{
+    starts.assign(1, 0);
+    factors.assign(1, 1.0);
+    if (symbolFactors == nullptr || symbolFactors->exDates.empty())
+    {
+        return;
+    }
+
+    // run k holds the bars with exactly k events applied, it starts at the first bar of the first day on or after the ex-date of event k - 1
+    const size_t eventCount = symbolFactors->exDates.size();
+    const double last = symbolFactors->cumulative.back();
+    factors[0] = mode == AdjustmentMode::Backward ? 1.0 : 1.0 / last;
+    auto day = days.begin();
+    for (size_t k = 0; k < eventCount; ++k)
+    {
+        uint64_t exDate = symbolFactors->exDates[k];
+        day = std::partition_point(day, days.end(), [exDate](const BarArchiveDay& d) { return d.date < exDate; });
+        starts.push_back(day != days.end() ? std::min<size_t>(day->firstBar, bars->data.size()) : bars->data.size());
+        factors.push_back(mode == AdjustmentMode::Backward ? symbolFactors->cumulative[k] : symbolFactors->cumulative[k] / last);
+    }
+}
+
+void StockData::AdjustedBarsView::CopyTo(Bar *destination, size_t first, size_t count) const
+{
+    const Bar* source = bars->data.data();
+    size_t end = first + count;
+    for (size_t segment = GetSegment(first); first < end; ++segment)
+    {
+        size_t segmentEnd = segment + 1 < starts.size() ? std::min(starts[segment + 1], end) : end;
+        const double factor = factors[segment];
+        for (size_t i = first; i < segmentEnd; ++i)
+        {
+            Bar& bar = *destination++;
+            bar.time = source[i].time;
+            bar.open = source[i].open * factor;
+            bar.high = source[i].high * factor;
+            bar.low = source[i].low * factor;
+            bar.close = source[i].close * factor;
+            bar.volume = source[i].volume;
+            bar.amount = source[i].amount;
+        }
+        first = segmentEnd;
+    }
+}
+
+void StockData::AdjustedBarsView::ToBars(Bars &result) const
+{
+    result.symbol = bars->symbol;
+    result.frequency = bars->frequency;
+    result.data.resize(size());
+    CopyTo(result.data.data(), 0, size());
+}
+
+StockData::AugmentedBars::AugmentedBars(const AdjustedBarsView &view)
+{
+    symbol = view.Symbol();
+    symbol.resize(6, '\0');
+    frequency = view.Frequency();
+    averageDistance = 0.0;
+    data.clear();
+    data.reserve(view.size());
+    for (size_t i = 0; i < view.size(); ++i)
+    {
+        const Bar bar = view[i];
+        data.push_back(AugmentedBar{
+            time: bar.time,
+            open: bar.open,
+            openNormalized: 0.0,
+            high: bar.high,
+            highNormalized: 0.0,
+            low: bar.low,
+            lowNormalized: 0.0,
+            close: bar.close,
+            closeNormalized: 0.0,
+            average: (bar.amount / bar.volume) * view.Factor(i),
+            averageNormalized: 0.0,
+            volume: bar.volume,
+            volumeNormalized: 0.0,
+            amount: bar.amount,
+            amountNormalized: 0.0,
+            barDistance: 0.0,
+            HasDistances: 0
+        });
+    }
+}
@@ -0,0 +1,150 @@
+#pragma once
+#include <algorithm>
+#include <cstddef>
+#include <cstdint>
+#include <iterator>
+#include <string>
+#include <unordered_map>
+#include <vector>
+
+#include "BarArchive.hpp"
+#include "StockData.hpp"
+
+namespace StockData
+{
+    // Price adjustment for splits and dividends. A corporate action is given as the ratio by which it divides the price
+    // on its ex-date: previous close / theoretical ex-price, e.g. 2.0 for a 2-for-1 split, slightly above 1.0 for a cash dividend.
+    // Forward adjustment keeps the latest prices and scales earlier ones down, backward adjustment keeps the earliest
+    // prices and scales later ones up. Only open, high, low and close are adjusted, volume and amount are left as traded
+
+    enum class AdjustmentMode
+    {
+        Forward = 0,
+        Backward
+    };
+
+    /// @brief Corporate actions of a symbol, with the cumulative factors precomputed
+    struct SymbolFactors
+    {
+        std::vector<uint64_t> exDates;  // ascending, YYYYMMDD
+        std::vector<double> ratios;     // ratio of each event
+        std::vector<double> cumulative; // cumulative[k] = product of the ratios of events 0 to k
+
+        /// @brief Factor of a bar of the given date (YYYYMMDD)
+        double GetFactor(uint64_t date, AdjustmentMode mode) const;
+    };
+
+    /// @brief Factors of every symbol of a corporate action file
+    struct AdjustmentFactors
+    {
+        /// @brief Load a factor file: one "symbol,exDate,ratio" line per event, e.g. "600000,20240712,1.0365",
+        /// in any order. Empty lines and lines starting with # are skipped
+        /// @return true if the file was read, false if it could not be opened or a line is malformed
+        bool Load(const std::string& filePath, std::string& error);
+
+        /// @brief Add one event, the cumulative factors of the symbol are recomputed
+        /// @return false if ratio is not a positive number
+        bool AddEvent(const std::string& symbol, uint64_t exDate, double ratio);
+
+        /// @return nullptr if the symbol has no corporate action
+        const SymbolFactors* Find(const std::string& symbol) const;
+
+        size_t SymbolCount() const { return symbols.size(); }
+
+    private:
+        std::unordered_map<std::string, SymbolFactors> symbols;
+    };
+
+    /// @brief Adjusted, read-only view of a Bars. Nothing is copied: a bar is adjusted when it is read,
+    /// and CopyTo adjusts whole runs of bars that share a factor at once.
+    /// The bars and the factors are not owned and must outlive the view
+    struct AdjustedBarsView
+    {
+        struct Iterator
+        {
+            using iterator_category = std::random_access_iterator_tag;
+            using value_type = Bar;
+            using difference_type = std::ptrdiff_t;
+            using pointer = void;
+            using reference = Bar;
+
+            const AdjustedBarsView* view = nullptr;
+            size_t index = 0;
+
+            Bar operator*() const { return (*view)[index]; }
+            Bar operator[](difference_type n) const { return (*view)[index + n]; }
+
+            Iterator& operator++() { ++index; return *this; }
+            Iterator operator++(int) { Iterator it = *this; ++index; return it; }
+            Iterator& operator--() { --index; return *this; }
+            Iterator operator--(int) { Iterator it = *this; --index; return it; }
+            Iterator& operator+=(difference_type n) { index += n; return *this; }
+            Iterator& operator-=(difference_type n) { index -= n; return *this; }
+            friend Iterator operator+(Iterator it, difference_type n) { return it += n; }
+            friend Iterator operator+(difference_type n, Iterator it) { return it += n; }
+            friend Iterator operator-(Iterator it, difference_type n) { return it -= n; }
+            friend difference_type operator-(const Iterator& a, const Iterator& b) { return difference_type(a.index) - difference_type(b.index); }
+            friend auto operator<=>(const Iterator& a, const Iterator& b) = default;
+        };
+
+        /// @param bars bars in ascending time order whose times carry the date: 1d (YYYYMMDD), or intraday timed YYYYMMDDHHMMSS
+        /// such as the output of MinuteBarAggregator or ResampleBars. Times of bars read from .1m.bars files are per day,
+        /// use the constructors taking their date or days. Intraday bars whose times are not dates are left unadjusted, with an error on std::cerr
+        /// @param factors factors of the symbol of the bars, nullptr for a symbol without corporate actions
+        AdjustedBarsView(const Bars& bars, const SymbolFactors* factors, AdjustmentMode mode);
+
+        /// @brief View of bars with the factors of their own symbol
+        AdjustedBarsView(const Bars& bars, const AdjustmentFactors& factors, AdjustmentMode mode);
+
+        /// @brief View of the bars of a single day, e.g. one .1m.bars file, whatever their times
+        /// @param date YYYYMMDD of every bar
+        AdjustedBarsView(const Bars& bars, uint64_t date, const SymbolFactors* factors, AdjustmentMode mode);
+
+        /// @brief View of the bars of several days whose times are per day, e.g. from ReadBarsRange
+        /// @param days date and bars of each day, in ascending date order, covering the bars back to back
+        AdjustedBarsView(const Bars& bars, const std::vector<BarArchiveDay>& days, const SymbolFactors* factors, AdjustmentMode mode);
+
+        const std::string& Symbol() const { return bars->symbol; }
+        DataFrequency Frequency() const { return bars->frequency; }
+        AdjustmentMode Mode() const { return mode; }
+        const Bars& Unadjusted() const { return *bars; }
+
+        size_t size() const { return bars->data.size(); }
+        bool empty() const { return bars->data.empty(); }
+
+        /// @brief Factor the prices of bar i are multiplied by
+        double Factor(size_t i) const { return factors[GetSegment(i)]; }
+
+        Bar operator[](size_t i) const
+        {
+            Bar bar = bars->data[i];
+            double factor = Factor(i);
+            bar.open *= factor;
+            bar.high *= factor;
+            bar.low *= factor;
+            bar.close *= factor;
+            return bar;
+        }
+
+        Iterator begin() const { return Iterator{this, 0}; }
+        Iterator end() const { return Iterator{this, size()}; }
+
+        /// @brief Adjusted copy of bars [first, first + count)
+        void CopyTo(Bar* destination, size_t first, size_t count) const;
+
+        /// @brief Materialises the view into an owning Bars
+        void ToBars(Bars& result) const;
+
+    private:
+        /// @brief Index of the run of bars that bar i belongs to, runs can be empty when events fall between two bars
+        size_t GetSegment(size_t i) const { return std::upper_bound(starts.begin(), starts.end(), i) - starts.begin() - 1; }
+
+        /// @param days the bars split into days, see the constructor taking days
+        void BuildSegments(const std::vector<BarArchiveDay>& days, const SymbolFactors* symbolFactors);
+
+        const Bars* bars;
+        AdjustmentMode mode;
+        std::vector<size_t> starts;  // first bar of each run of bars sharing a factor, starts[0] = 0
+        std::vector<double> factors; // factor of each run
+    };
+}
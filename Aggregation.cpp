@@ -0,0 +1,316 @@
+#include "Aggregation.hpp"
+#include "Parallel.hpp"
+#include "TickStream.hpp"
+#include <algorithm>
+
+namespace
+{
+    constexpr uint64_t MORNING_OPEN = 9 * 60 + 30;   // minutes of the day
+    constexpr uint64_t MORNING_CLOSE = 11 * 60 + 30;
+    constexpr uint64_t AFTERNOON_OPEN = 13 * 60;
+    constexpr uint64_t AFTERNOON_CLOSE = 15 * 60;
+    constexpr size_t MORNING_MINUTES = MORNING_CLOSE - MORNING_OPEN;
+
+    uint64_t GetMinuteOfDay(uint64_t timeOfDay)
+    {
+        return timeOfDay / 10000 * 60 + timeOfDay / 100 % 100;
+    }
+
+    /// @brief Shared by the ResampleBars overloads
+    /// @param getDate date of bar i
+    template <typename GetDate>
+    bool Resample(const StockData::Bars& source, StockData::DataFrequency frequency, GetDate&& getDate, StockData::Bars& result)
+    {
+        using namespace StockData;
+        result.symbol = source.symbol;
+        result.frequency = frequency;
+        result.data.clear();
+
+        int sourceSeconds = static_cast<int>(source.frequency);
+        int targetSeconds = static_cast<int>(frequency);
+        if (source.frequency == DataFrequency::Undefined || source.frequency == DataFrequency::Tick
+            || source.frequency == DataFrequency::Bar1d || targetSeconds <= sourceSeconds
+            || (frequency != DataFrequency::Bar1d && targetSeconds % 60 != 0))
+        {
+            return false;
+        }
+
+        const bool daily = frequency == DataFrequency::Bar1d;
+        const size_t bucketMinutes = targetSeconds / 60;
+        result.data.reserve(daily ? 1 : source.data.size() * sourceSeconds / targetSeconds + 1);
+
+        bool hasCurrent = false;
+        uint64_t currentKey = 0;
+        Bar current{};
+        for (size_t i = 0; i < source.data.size(); ++i)
+        {
+            const Bar& bar = source.data[i];
+            uint64_t date = getDate(i);
+            uint64_t key, time;
+            if (daily)
+            {
+                key = date;
+                time = date;
+            }
+            else
+            {
+                size_t bucket = GetSessionMinuteIndexOfLabel(GetBarTimeOfDay(bar.time)) / bucketMinutes;
+                size_t lastIndex = std::min((bucket + 1) * bucketMinutes, SESSION_MINUTES) - 1;
+                time = MakeBarTime(date, GetSessionMinuteLabel(lastIndex));
+                key = time;
+            }
+
+            if (hasCurrent && key == currentKey)
+            {
+                current.high = std::max(current.high, bar.high);
+                current.low = std::min(current.low, bar.low);
+                current.close = bar.close;
+                current.volume += bar.volume;
+                current.amount += bar.amount;
+            }
+            else
+            {
+                if (hasCurrent)
+                {
+                    result.data.push_back(current);
+                }
+                hasCurrent = true;
+                currentKey = key;
+                current = Bar{time, bar.open, bar.high, bar.low, bar.close, bar.volume, bar.amount};
+            }
+        }
+        if (hasCurrent)
+        {
+            result.data.push_back(current);
+        }
+        return true;
+    }
+}
+
+size_t StockData::GetSessionMinuteIndex(uint64_t timeOfDay)
+{
+    uint64_t minute = GetMinuteOfDay(timeOfDay);
+    if (minute < MORNING_OPEN)
+    {
+        return 0; // opening call auction
+    }
+    if (minute < MORNING_CLOSE)
+    {
+        return minute - MORNING_OPEN;
+    }
+    if (minute < AFTERNOON_OPEN)
+    {
+        return MORNING_MINUTES - 1; // lunch break
+    }
+    if (minute < AFTERNOON_CLOSE)
+    {
+        return MORNING_MINUTES + minute - AFTERNOON_OPEN;
+    }
+    return SESSION_MINUTES - 1; // closing call auction match
+}
+
+uint64_t StockData::GetSessionMinuteLabel(size_t index)
+{
+    uint64_t minute = index < MORNING_MINUTES ? MORNING_OPEN + 1 + index : AFTERNOON_OPEN + 1 + (index - MORNING_MINUTES);
+    return minute / 60 * 10000 + minute % 60 * 100;
+}
+
+size_t StockData::GetSessionMinuteIndexOfLabel(uint64_t label)
+{
+    long minute = GetMinuteOfDay(label);
+    long index = minute <= static_cast<long>(MORNING_CLOSE)
+        ? minute - static_cast<long>(MORNING_OPEN) - 1
+        : static_cast<long>(MORNING_MINUTES) + minute - static_cast<long>(AFTERNOON_OPEN) - 1;
+    return std::clamp(index, 0L, static_cast<long>(SESSION_MINUTES) - 1);
+}
+
+void StockData::MinuteBarAggregator::Reset(uint64_t tradeDate)
+{
+    date = tradeDate;
+    lastDayVolume = 0.0;
+    lastDayAmount = 0.0;
+    std::fill(std::begin(traded), std::end(traded), false);
+    anyTrade = false;
+}
+
+void StockData::MinuteBarAggregator::Push(const Tick &tick)
+{
+    double volume = tick.dayVolume - lastDayVolume;
+    double amount = tick.dayAmount - lastDayAmount;
+    if (volume == 0.0)
+    {
+        return; // a quote update, nothing traded
+    }
+    lastDayVolume = tick.dayVolume;
+    lastDayAmount = tick.dayAmount;
+    if (volume < 0.0 || tick.price <= 0.0)
+    {
+        return; // the day totals went backwards or no price, resync without counting anything
+    }
+
+    size_t index = GetSessionMinuteIndex(tick.time);
+    Bar& bar = minutes[index];
+    if (!traded[index])
+    {
+        bar = Bar{0, tick.price, tick.price, tick.price, tick.price, 0.0, 0.0};
+        traded[index] = true;
+    }
+    else
+    {
+        bar.high = std::max(bar.high, tick.price);
+        bar.low = std::min(bar.low, tick.price);
+        bar.close = tick.price;
+    }
+    bar.volume += volume;
+    bar.amount += amount;
+    anyTrade = true;
+}
+
+bool StockData::MinuteBarAggregator::Finish(Bars &bars) const
+{
+    bars.frequency = DataFrequency::Bar1m;
+    bars.data.clear();
+    if (!anyTrade)
+    {
+        return false;
+    }
+
+    double lastPrice = minutes[std::find(std::begin(traded), std::end(traded), true) - std::begin(traded)].open;
+    bars.data.resize(SESSION_MINUTES);
+    for (size_t i = 0; i < SESSION_MINUTES; ++i)
+    {
+        Bar& bar = bars.data[i];
+        if (traded[i])
+        {
+            bar = minutes[i];
+            lastPrice = bar.close;
+        }
+        else
+        {
+            bar = Bar{0, lastPrice, lastPrice, lastPrice, lastPrice, 0.0, 0.0};
+        }
+        bar.time = MakeBarTime(date, GetSessionMinuteLabel(i));
+    }
+    return true;
+}
+
+bool StockData::AggregateTicks(const Ticks &ticks, Bars &bars)
+{
+    MinuteBarAggregator aggregator;
+    aggregator.Reset(ticks.date);
+    for (size_t i = 0; i < ticks.tickCount; ++i)
+    {
+        aggregator.Push(ticks.data[i]);
+    }
+    bars.symbol = std::string(ticks.symbol, strnlen(ticks.symbol, SYMBOL_SIZE));
+    return aggregator.Finish(bars);
+}
+
+bool StockData::AggregateTicks(const std::string &filePath, Bars &bars)
+{
+    std::string error;
+    return AggregateTicks(filePath, bars, error);
+}
+
+bool StockData::AggregateTicks(const std::string &filePath, Bars &bars, std::string &error)
+{
+    TickStream stream;
+    if (!stream.Open(filePath))
+    {
+        error = "Failed to open file: " + filePath;
+        bars.Clear();
+        return false;
+    }
+
+    MinuteBarAggregator aggregator;
+    aggregator.Reset(stream.date);
+    for (auto batch = stream.NextBatch(); !batch.empty(); batch = stream.NextBatch())
+    {
+        for (const Tick& tick : batch)
+        {
+            aggregator.Push(tick);
+        }
+    }
+    bars.symbol = std::string(stream.symbol, strnlen(stream.symbol, SYMBOL_SIZE));
+    if (!aggregator.Finish(bars))
+    {
+        error = "No trades in " + filePath;
+        return false;
+    }
+    return true;
+}
+
+bool StockData::ResampleBars(const Bars &source, DataFrequency frequency, Bars &result)
+{
+    // per-day times would all decode to date 0 and merge every day into one
+    for (const Bar& bar : source.data)
+    {
+        if (!HasBarDate(bar.time))
+        {
+            result.symbol = source.symbol;
+            result.frequency = frequency;
+            result.data.clear();
+            return false;
+        }
+    }
+    return Resample(source, frequency, [&](size_t i) { return GetBarDate(source.data[i].time); }, result);
+}
+
+bool StockData::ResampleBars(const Bars &source, const std::vector<BarArchiveDay> &days, DataFrequency frequency, Bars &result)
+{
+    // dates[i] is the date of bar i, the days must cover the bars back to back
+    std::vector<uint64_t> dates(source.data.size());
+    size_t covered = 0;
+    for (const BarArchiveDay& day : days)
+    {
+        if (day.firstBar != covered || day.firstBar + day.barCount > dates.size())
+        {
+            break;
+        }
+        std::fill(dates.begin() + day.firstBar, dates.begin() + day.firstBar + day.barCount, day.date);
+        covered += day.barCount;
+    }
+    if (covered != source.data.size())
+    {
+        result.symbol = source.symbol;
+        result.frequency = frequency;
+        result.data.clear();
+        return false;
+    }
+    return Resample(source, frequency, [&](size_t i) { return dates[i]; }, result);
+}
+
+void StockData::AggregateDay(const std::vector<std::string> &symbols, uint64_t date, size_t threads, Universe &universe)
+{
+    universe.Clear();
+    universe.frequency = DataFrequency::Bar1m;
+    universe.symbols = symbols;
+    universe.bars.resize(symbols.size());
+    for (size_t i = 0; i < symbols.size(); ++i)
+    {
+        universe.symbolIndices.emplace(symbols[i], i);
+    }
+
+    std::vector<std::string> errors(symbols.size()); // empty for the symbols that succeeded
+    std::vector<std::string> filePaths(symbols.size());
+    ParallelFor(symbols.size(), threads, [&](size_t i)
+    {
+        filePaths[i] = GetFilePath(symbols[i], DataFrequency::Tick, date);
+        if (filePaths[i].empty())
+        {
+            errors[i] = "No tick file for " + symbols[i];
+        }
+        else
+        {
+            AggregateTicks(filePaths[i], universe.bars[i], errors[i]);
+        }
+    });
+
+    for (size_t i = 0; i < symbols.size(); ++i)
+    {
+        if (!errors[i].empty())
+        {
+            universe.failures.push_back(LoadFailure{i, filePaths[i], errors[i]});
+        }
+    }
+}
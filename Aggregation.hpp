@@ -0,0 +1,99 @@
+#pragma once
+#include <cstddef>
+#include <cstdint>
+#include <string>
+#include <vector>
+
+#include "BarArchive.hpp"
+#include "StockData.hpp"
+#include "Universe.hpp"
+
+namespace StockData
+{
+    // A-share continuous sessions are 09:30-11:30 and 13:00-15:00, i.e. 240 one-minute bars.
+    // Bars are labelled by the minute they end on (09:31 for 09:30:00-09:30:59, as is the convention),
+    // and bar times are YYYYMMDDHHMMSS so that multi-day series stay sorted.
+    // The opening call auction (09:15-09:25) folds into the first bar, the lunch break into 11:30,
+    // and the closing call auction match at 15:00 into the last bar.
+    constexpr size_t SESSION_MINUTES = 240;
+
+    /// @brief Bar time from a date and a time of day
+    /// @param date e.g. 20240105
+    /// @param timeOfDay HHMMSS, e.g. 93100
+    constexpr uint64_t MakeBarTime(uint64_t date, uint64_t timeOfDay) { return date * 1000000 + timeOfDay; }
+    constexpr uint64_t GetBarDate(uint64_t barTime) { return barTime / 1000000; }
+    constexpr uint64_t GetBarTimeOfDay(uint64_t barTime) { return barTime % 1000000; }
+
+    /// @brief true if a bar time carries its date (YYYYMMDDHHMMSS), false for the per-day times bars are read with from .1m.bars files
+    constexpr bool HasBarDate(uint64_t barTime) { return barTime >= 10000101000000ULL; }
+
+    /// @brief Index of the one-minute bar a tick falls into
+    /// @param timeOfDay HHMMSS of the tick, e.g. 103003
+    /// @return 0 to SESSION_MINUTES - 1, ticks outside of the sessions are folded into the nearest bar
+    size_t GetSessionMinuteIndex(uint64_t timeOfDay);
+
+    /// @brief Time of day (HHMMSS) a one-minute bar is labelled with
+    /// @param index 0 to SESSION_MINUTES - 1
+    uint64_t GetSessionMinuteLabel(size_t index);
+
+    /// @brief Inverse of GetSessionMinuteLabel
+    /// @param label HHMMSS a bar is labelled with, e.g. 93100
+    size_t GetSessionMinuteIndexOfLabel(uint64_t label);
+
+    /// @brief Builds the one-minute bars of a day from ticks pushed in time order.
+    /// Volume and amount are the deltas of dayVolume and dayAmount, and only ticks that traded move OHLC.
+    /// Minutes without trades repeat the last price with no volume, minutes before the first trade use the first price
+    struct MinuteBarAggregator
+    {
+        /// @brief Start a new day
+        void Reset(uint64_t date);
+
+        void Push(const Tick& tick);
+
+        /// @brief Write the bars of the day, SESSION_MINUTES of them
+        /// @return false if nothing traded, bars is then left empty
+        bool Finish(Bars& bars) const;
+
+    private:
+        uint64_t date = 0;
+        double lastDayVolume = 0.0;
+        double lastDayAmount = 0.0;
+        Bar minutes[SESSION_MINUTES];
+        bool traded[SESSION_MINUTES] = {};
+        bool anyTrade = false;
+    };
+
+    /// @brief Builds the one-minute bars of a day of ticks, see MinuteBarAggregator
+    /// @return false if nothing traded
+    bool AggregateTicks(const Ticks& ticks, Bars& bars);
+
+    /// @brief Builds the one-minute bars of a tick file, reading it in chunks
+    /// @return false if the file could not be read or nothing traded
+    bool AggregateTicks(const std::string& filePath, Bars& bars);
+
+    /// @brief Same as above, telling a file that could not be read from a day without trades
+    /// @param error set to the reason of the failure, if any
+    bool AggregateTicks(const std::string& filePath, Bars& bars, std::string& error);
+
+    /// @brief Resample bars to a coarser frequency in one pass
+    /// @param source Bar1m or coarser intraday bars, times in YYYYMMDDHHMMSS, possibly over several days
+    /// @param frequency Bar5m, Bar15m, Bar30m, Bar60m or Bar1d. Intraday bars never span the lunch break,
+    /// e.g. 60m bars end at 10:30, 11:30, 14:00 and 15:00. Daily bars are timed YYYYMMDD
+    /// @param result the resampled bars, gets cleared in this function
+    /// @return false if the frequency is not coarser than the source's, or if the bar times are not YYYYMMDDHHMMSS
+    /// (bars read from .1m.bars files are timed per day, see the overload taking days)
+    bool ResampleBars(const Bars& source, DataFrequency frequency, Bars& result);
+
+    /// @brief Same as above for bars of several days whose times are per day, e.g. from ReadBarsRange or LoadUniverse.
+    /// The time of day of a bar is its time modulo 1000000 (HHMMSS), its date comes from days
+    /// @param days date and bars of each day, in ascending date order, covering the bars back to back
+    /// @return false if the frequency is not coarser than the source's or the days do not cover the bars
+    bool ResampleBars(const Bars& source, const std::vector<BarArchiveDay>& days, DataFrequency frequency, Bars& result);
+
+    /// @brief Builds the one-minute bars of a day for many symbols from their tick files, on a pool of worker threads
+    /// @param symbols symbols to aggregate
+    /// @param date the day, e.g. 20240105
+    /// @param threads number of worker threads, 0 for one per hardware thread
+    /// @param universe the results, indexed like symbols, gets cleared in this function
+    void AggregateDay(const std::vector<std::string>& symbols, uint64_t date, size_t threads, Universe& universe);
+}
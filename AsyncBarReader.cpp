@@ -0,0 +1,316 @@
+#include "AsyncBarReader.hpp"
+#include "Parallel.hpp"
+#include <cerrno>
+#include <cstring>
+
+#if __has_include(<liburing.h>)
+#include <fcntl.h>
+#include <liburing.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#define STOCKDATA_ASYNC_IO_URING 1
+#endif
+
+#ifdef STOCKDATA_ASYNC_IO_URING
+namespace
+{
+    constexpr unsigned RING_DEPTH = 64; // reads in flight at once
+
+    /// @brief A file being read through the ring, owned by the ring thread until its last completion
+    struct RingRead
+    {
+        size_t dayIndex;
+        size_t symbolIndex;
+        std::string filePath;
+        int fd = -1;
+        std::vector<char> buffer;
+        size_t done = 0;
+    };
+
+    void PrepareRead(io_uring& ring, RingRead* read)
+    {
+        io_uring_sqe* sqe = io_uring_get_sqe(&ring); // never full, there is at most one entry per read in flight
+        io_uring_prep_read(sqe, read->fd, read->buffer.data() + read->done, read->buffer.size() - read->done, read->done);
+        io_uring_sqe_set_data(sqe, read);
+    }
+
+    /// @brief Same checks and results as ReadBars(filePath, bars, error), on a file already in memory
+    bool ParseBars(const RingRead& read, StockData::Bars& bars, std::string& error)
+    {
+        size_t fileSize = read.buffer.size();
+        size_t dataSize = fileSize >= StockData::BAR_INFO_SIZE ? StockData::GetBarsDataSize(read.filePath, fileSize) : fileSize;
+        if (dataSize >= fileSize)
+        {
+            error = "File too small for bars: " + read.filePath;
+            return false;
+        }
+        StockData::ReadBars(read.buffer.data(), dataSize + StockData::BAR_INFO_SIZE, bars);
+        bars.symbol.resize(StockData::BARS_SYMBOL_SIZE + 1, '\0');
+        return true;
+    }
+}
+
+struct StockData::AsyncBarReader::Ring
+{
+    io_uring ring;
+};
+#else
+struct StockData::AsyncBarReader::Ring
+{};
+#endif
+
+StockData::AsyncBarReader::AsyncBarReader(const std::vector<std::string> &readSymbols, const std::vector<uint64_t> &readDates, const AsyncBarReaderOptions &readerOptions)
+    : symbols(readSymbols), dates(readDates), options(readerOptions), days(readDates.size())
+{
+    options.daysAhead = std::max<size_t>(options.daysAhead, 1);
+
+#ifdef STOCKDATA_ASYNC_IO_URING
+    if (options.useIoUring)
+    {
+        ring = std::make_unique<Ring>();
+        if (io_uring_queue_init(RING_DEPTH, &ring->ring, 0) == 0)
+        {
+            threads.emplace_back(&AsyncBarReader::RunRing, this);
+            return;
+        }
+        ring.reset(); // e.g. io_uring disabled in this container, fall back to the thread pool
+    }
+#endif
+
+    size_t threadCount = options.threads > 0 ? options.threads : DefaultThreadCount();
+    for (size_t i = 0; i < threadCount; ++i)
+    {
+        threads.emplace_back(&AsyncBarReader::RunWorker, this);
+    }
+}
+
+StockData::AsyncBarReader::~AsyncBarReader()
+{
+    {
+        std::lock_guard lock(mutex);
+        stopping = true;
+    }
+    requestsChanged.notify_all();
+    for (std::thread& thread : threads)
+    {
+        thread.join();
+    }
+}
+
+std::future<StockData::DayBars> StockData::AsyncBarReader::Next()
+{
+    if (nextDate >= dates.size())
+    {
+        return std::future<DayBars>();
+    }
+
+    while (submittedDates < std::min(nextDate + options.daysAhead, dates.size()))
+    {
+        Submit(submittedDates++);
+    }
+    return days[nextDate++]->promise.get_future();
+}
+
+void StockData::AsyncBarReader::Submit(size_t dayIndex)
+{
+    auto day = std::make_unique<DayState>();
+    day->result.date = dates[dayIndex];
+    day->result.bars.resize(symbols.size());
+    day->errors.resize(symbols.size());
+    day->remaining = symbols.size();
+    if (symbols.empty())
+    {
+        day->promise.set_value(std::move(day->result));
+    }
+    days[dayIndex] = std::move(day);
+
+    {
+        std::lock_guard lock(mutex);
+        for (size_t i = 0; i < symbols.size(); ++i)
+        {
+            requests.push_back(FileRequest{dayIndex, i});
+        }
+    }
+    requestsChanged.notify_all();
+}
+
+void StockData::AsyncBarReader::Complete(const FileRequest &request, const std::string &error)
+{
+    DayState& day = *days[request.dayIndex];
+    if (!error.empty())
+    {
+        day.result.bars[request.symbolIndex] = Bars();
+        day.errors[request.symbolIndex] = error;
+    }
+    if (day.remaining.fetch_sub(1, std::memory_order_acq_rel) != 1)
+    {
+        return;
+    }
+
+    // last file of the day, every other reader is done with it
+    for (size_t i = 0; i < symbols.size(); ++i)
+    {
+        if (!day.errors[i].empty())
+        {
+            day.result.failures.push_back(LoadFailure{i, GetFilePath(symbols[i], DataFrequency::Bar1m, day.result.date), day.errors[i]});
+        }
+    }
+    day.promise.set_value(std::move(day.result));
+}
+
+void StockData::AsyncBarReader::RunWorker()
+{
+    for (;;)
+    {
+        FileRequest request;
+        {
+            std::unique_lock lock(mutex);
+            requestsChanged.wait(lock, [this]() { return stopping || !requests.empty(); });
+            if (stopping)
+            {
+                return;
+            }
+            request = requests.front();
+            requests.pop_front();
+        }
+
+        std::string error;
+        Bars& bars = days[request.dayIndex]->result.bars[request.symbolIndex];
+        if (!ReadBars(GetFilePath(symbols[request.symbolIndex], DataFrequency::Bar1m, dates[request.dayIndex]), bars, error) && error.empty())
+        {
+            error = "Failed to read bars";
+        }
+        Complete(request, error);
+    }
+}
+
+void StockData::AsyncBarReader::RunRing()
+{
+#ifdef STOCKDATA_ASYNC_IO_URING
+    io_uring& uring = ring->ring;
+    size_t inFlight = 0;
+    std::vector<FileRequest> batch;
+    for (;;)
+    {
+        batch.clear();
+        {
+            std::unique_lock lock(mutex);
+            if (inFlight == 0)
+            {
+                requestsChanged.wait(lock, [this]() { return stopping || !requests.empty(); });
+            }
+            if (stopping)
+            {
+                break;
+            }
+            while (!requests.empty() && inFlight + batch.size() < RING_DEPTH)
+            {
+                batch.push_back(requests.front());
+                requests.pop_front();
+            }
+        }
+
+        // opening stays synchronous, the size of the file is needed for the read
+        for (const FileRequest& request : batch)
+        {
+            auto read = std::make_unique<RingRead>();
+            read->filePath = GetFilePath(symbols[request.symbolIndex], DataFrequency::Bar1m, dates[request.dayIndex]);
+            read->fd = open(read->filePath.c_str(), O_RDONLY);
+            struct stat status;
+            if (read->fd < 0 || fstat(read->fd, &status) != 0)
+            {
+                if (read->fd >= 0)
+                {
+                    close(read->fd);
+                }
+                Complete(request, "Failed to open file: " + read->filePath);
+                continue;
+            }
+            STOCKDATA_METRIC_IO(ReadBars, 0, 1);
+            read->dayIndex = request.dayIndex;
+            read->symbolIndex = request.symbolIndex;
+            read->buffer.resize(status.st_size);
+            if (read->buffer.empty())
+            {
+                std::string error;
+                Bars& bars = days[request.dayIndex]->result.bars[request.symbolIndex];
+                ParseBars(*read, bars, error);
+                close(read->fd);
+                Complete(request, error);
+                continue;
+            }
+            PrepareRead(uring, read.release());
+            ++inFlight;
+        }
+        io_uring_submit(&uring);
+        if (inFlight == 0)
+        {
+            continue;
+        }
+
+        io_uring_cqe* cqe;
+        if (io_uring_wait_cqe(&uring, &cqe) != 0)
+        {
+            continue; // interrupted
+        }
+        do
+        {
+            RingRead* read = static_cast<RingRead*>(io_uring_cqe_get_data(cqe));
+            int result = cqe->res;
+            io_uring_cqe_seen(&uring, cqe);
+
+            std::string error;
+            if (result < 0)
+            {
+                error = "Failed to read file: " + read->filePath + ": " + strerror(-result);
+            }
+            else if (result == 0)
+            {
+                error = "Failed to read file: " + read->filePath;
+            }
+            else
+            {
+                read->done += result;
+                if (read->done < read->buffer.size())
+                {
+                    PrepareRead(uring, read); // short read, ask for the rest
+                    continue;
+                }
+                ParseBars(*read, days[read->dayIndex]->result.bars[read->symbolIndex], error);
+            }
+            close(read->fd);
+            Complete(FileRequest{read->dayIndex, read->symbolIndex}, error);
+            delete read;
+            --inFlight;
+        } while (io_uring_peek_cqe(&uring, &cqe) == 0);
+        io_uring_submit(&uring);
+    }
+
+    // the kernel may still write into the buffers of reads in flight, wait for them before freeing
+    while (inFlight > 0)
+    {
+        io_uring_cqe* cqe;
+        if (io_uring_wait_cqe(&uring, &cqe) != 0)
+        {
+            continue;
+        }
+        RingRead* read = static_cast<RingRead*>(io_uring_cqe_get_data(cqe));
+        io_uring_cqe_seen(&uring, cqe);
+        close(read->fd);
+        delete read;
+        --inFlight;
+    }
+    io_uring_queue_exit(&uring);
+#endif
+}
+
+void StockData::ReadDays(const std::vector<std::string> &symbols, const std::vector<uint64_t> &dates, const AsyncBarReaderOptions &options,
+                         const std::function<void(DayBars &day)> &function)
+{
+    AsyncBarReader reader(symbols, dates, options);
+    while (reader.HasNext())
+    {
+        DayBars day = reader.Next().get();
+        function(day);
+    }
+}
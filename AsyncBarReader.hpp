@@ -0,0 +1,103 @@
+#pragma once
+#include <atomic>
+#include <condition_variable>
+#include <cstddef>
+#include <cstdint>
+#include <deque>
+#include <functional>
+#include <future>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <vector>
+
+#include "StockData.hpp"
+#include "Universe.hpp"
+
+namespace StockData
+{
+    /// @brief The 1m bars of every symbol for one date
+    struct DayBars
+    {
+        uint64_t date = 0;
+        std::vector<Bars> bars;            // bars[i] belongs to symbols[i], empty if its file could not be read
+        std::vector<LoadFailure> failures; // ordered by symbol index
+    };
+
+    struct AsyncBarReaderOptions
+    {
+        size_t daysAhead = 4;   // days whose files are in flight ahead of the one being consumed, at least 1
+        size_t threads = 0;     // reader threads of the thread pool fallback, 0 for one per hardware thread
+        bool useIoUring = true; // use io_uring when built with liburing and the kernel allows it, the thread pool otherwise
+    };
+
+    /// @brief Reads the <date>.1m.bars files of a set of symbols date by date, keeping the files of the next days
+    /// in flight while the caller works on the current one.
+    /// With io_uring (built when liburing.h is found, link with -luring) a single thread submits the reads and parses completions,
+    /// otherwise a pool of threads calls ReadBars
+    struct AsyncBarReader
+    {
+        /// @param symbols symbols to read, e.g. "600000"
+        /// @param dates dates to read, in the order they are handed back
+        AsyncBarReader(const std::vector<std::string>& symbols, const std::vector<uint64_t>& dates, const AsyncBarReaderOptions& options = AsyncBarReaderOptions());
+
+        /// @brief Stops the readers, futures of days not read yet are left with a broken promise
+        ~AsyncBarReader();
+
+        AsyncBarReader(const AsyncBarReader&) = delete;
+        AsyncBarReader& operator=(const AsyncBarReader&) = delete;
+
+        /// @return true while Next has days left to hand out
+        bool HasNext() const { return nextDate < dates.size(); }
+
+        /// @brief Future of the next date, in the order of the constructor's dates.
+        /// Also puts the files of the following daysAhead - 1 dates in flight. Must be called from one thread at a time
+        std::future<DayBars> Next();
+
+        /// @return true if reads go through io_uring, false for the thread pool
+        bool UsesIoUring() const { return ring != nullptr; }
+
+    private:
+        struct DayState
+        {
+            std::promise<DayBars> promise;
+            DayBars result;
+            std::vector<std::string> errors;
+            std::atomic<size_t> remaining;
+        };
+
+        struct FileRequest
+        {
+            size_t dayIndex;
+            size_t symbolIndex;
+        };
+
+        struct Ring; // io_uring state, only defined when built with liburing
+
+        void Submit(size_t dayIndex);
+        void Complete(const FileRequest& request, const std::string& error);
+        void RunWorker();
+        void RunRing();
+
+        std::vector<std::string> symbols;
+        std::vector<uint64_t> dates;
+        AsyncBarReaderOptions options;
+        size_t nextDate = 0;
+        size_t submittedDates = 0;
+        std::vector<std::unique_ptr<DayState>> days;
+
+        std::mutex mutex;
+        std::condition_variable requestsChanged;
+        std::deque<FileRequest> requests;
+        bool stopping = false;
+
+        std::unique_ptr<Ring> ring;
+        std::vector<std::thread> threads;
+    };
+
+    /// @brief Read the 1m bars of the symbols date by date and call function with each day, in date order, on the calling thread,
+    /// while the files of the next days are being read
+    void ReadDays(const std::vector<std::string>& symbols, const std::vector<uint64_t>& dates, const AsyncBarReaderOptions& options,
+                  const std::function<void(DayBars& day)>& function);
+}
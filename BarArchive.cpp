@@ -0,0 +1,151 @@
+#include "BarArchive.hpp"
+#include <algorithm>
+#include <cstdio>
+#include <fstream>
+#include <iostream>
+
+namespace
+{
+    constexpr char BAR_ARCHIVE_MAGIC[4] = {'S', 'D', 'B', 'A'};
+}
+
+std::string StockData::GetBarArchivePath(const std::string &symbol)
+{
+    return DATA_DIR_1M + '/' + symbol + ".1m.archive";
+}
+
+bool StockData::ConvertToBarArchive(const std::string &symbol, const std::string &archivePath, std::string &error)
+{
+    std::vector<uint64_t> dates;
+    if (!ListMinuteBarDates(symbol, dates, error))
+    {
+        return false;
+    }
+
+    // the bars are streamed day by day, the index is written once all the days are known
+    const std::string temporaryPath = archivePath + ".tmp";
+    std::ofstream file(temporaryPath, std::ios::binary | std::ios::trunc);
+    if (!file.is_open())
+    {
+        error = "Failed to open file: " + temporaryPath;
+        return false;
+    }
+
+    BarArchiveHeader header{};
+    memcpy(header.magic, BAR_ARCHIVE_MAGIC, sizeof(header.magic));
+    header.version = BAR_ARCHIVE_VERSION;
+    memcpy(header.symbol, symbol.data(), std::min(symbol.size(), SYMBOL_SIZE));
+    header.frequency = static_cast<int32_t>(DataFrequency::Bar1m);
+    header.dayCount = dates.size();
+
+    std::vector<BarArchiveDay> days(dates.size());
+    file.write((const char*)&header, sizeof(header));
+    file.write((const char*)days.data(), days.size() * sizeof(BarArchiveDay));
+
+    Bars dayBars;
+    for (size_t i = 0; i < dates.size(); ++i)
+    {
+        std::string filePath = GetFilePath(symbol, DataFrequency::Bar1m, dates[i]);
+        if (!ReadBars(filePath, dayBars, error))
+        {
+            file.close();
+            std::remove(temporaryPath.c_str());
+            return false;
+        }
+        days[i] = BarArchiveDay{dates[i], header.barCount, dayBars.data.size()};
+        header.barCount += dayBars.data.size();
+        file.write((const char*)dayBars.data.data(), dayBars.data.size() * sizeof(Bar));
+    }
+
+    file.seekp(0);
+    file.write((const char*)&header, sizeof(header));
+    file.write((const char*)days.data(), days.size() * sizeof(BarArchiveDay));
+    file.close();
+    if (!file)
+    {
+        error = "Failed to write file: " + temporaryPath;
+        std::remove(temporaryPath.c_str());
+        return false;
+    }
+
+    if (std::rename(temporaryPath.c_str(), archivePath.c_str()) != 0)
+    {
+        error = "Failed to rename " + temporaryPath + " to " + archivePath;
+        std::remove(temporaryPath.c_str());
+        return false;
+    }
+    return true;
+}
+
+bool StockData::ReadBarsRange(const std::string &symbol, uint64_t fromDate, uint64_t toDate, Bars &bars, std::vector<BarArchiveDay> *days)
+{
+    return ReadBarsRangeFromArchive(GetBarArchivePath(symbol), fromDate, toDate, bars, days);
+}
+
+bool StockData::ReadBarsRangeFromArchive(const std::string &archivePath, uint64_t fromDate, uint64_t toDate, Bars &bars, std::vector<BarArchiveDay> *days)
+{
+    bars.data.clear();
+    if (days != nullptr)
+    {
+        days->clear();
+    }
+
+    std::ifstream file(archivePath, std::ios::binary);
+    if (!file.is_open())
+    {
+        std::cerr << "Failed to open file: " << archivePath << '\n';
+        return false;
+    }
+
+    BarArchiveHeader header;
+    file.read((char*)&header, sizeof(header));
+    if (!file || memcmp(header.magic, BAR_ARCHIVE_MAGIC, sizeof(header.magic)) != 0 || header.version != BAR_ARCHIVE_VERSION)
+    {
+        std::cerr << "Invalid bar archive: " << archivePath << '\n';
+        return false;
+    }
+
+    std::vector<BarArchiveDay> index(header.dayCount);
+    file.read((char*)index.data(), index.size() * sizeof(BarArchiveDay));
+    if (!file)
+    {
+        std::cerr << "Failed to read the day index: " << archivePath << '\n';
+        return false;
+    }
+
+    bars.symbol.assign(BARS_SYMBOL_SIZE + 1, '\0'); // +1 for null terminator, same as ReadBars
+    memcpy(bars.symbol.data(), header.symbol, BARS_SYMBOL_SIZE);
+    bars.frequency = static_cast<DataFrequency>(header.frequency);
+
+    auto first = std::lower_bound(index.begin(), index.end(), fromDate,
+        [](const BarArchiveDay& day, uint64_t date) { return day.date < date; });
+    auto last = std::upper_bound(first, index.end(), toDate,
+        [](uint64_t date, const BarArchiveDay& day) { return date < day.date; });
+    if (first == last)
+    {
+        return true;
+    }
+
+    // days are stored back to back, so the range is one contiguous run of bars
+    uint64_t firstBar = first->firstBar;
+    uint64_t barCount = (last - 1)->firstBar + (last - 1)->barCount - firstBar;
+    bars.data = std::vector<Bar>(barCount);
+    file.seekg(sizeof(BarArchiveHeader) + index.size() * sizeof(BarArchiveDay) + firstBar * sizeof(Bar));
+    file.read((char*)bars.data.data(), barCount * sizeof(Bar));
+    if (!file)
+    {
+        std::cerr << "Failed to read bars: " << archivePath << '\n';
+        bars.data.clear();
+        return false;
+    }
+
+    if (days != nullptr)
+    {
+        days->reserve(last - first);
+        for (auto it = first; it != last; ++it)
+        {
+            days->push_back(BarArchiveDay{it->date, it->firstBar - firstBar, it->barCount});
+        }
+    }
+    return true;
+}
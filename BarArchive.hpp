@@ -0,0 +1,54 @@
+#pragma once
+#include <cstddef>
+#include <cstdint>
+#include <string>
+#include <vector>
+
+#include "StockData.hpp"
+
+namespace StockData
+{
+    // A bar archive packs all the .1m.bars days of a symbol into one file:
+    // header, one BarArchiveDay per day sorted by date, then the bars of every day back to back.
+    constexpr uint32_t BAR_ARCHIVE_VERSION = 1;
+
+    struct BarArchiveHeader
+    {
+        char magic[4];         // "SDBA"
+        uint32_t version;
+        char symbol[SYMBOL_SIZE];
+        int32_t frequency;     // DataFrequency of the bars
+        uint32_t dayCount;
+        uint64_t barCount;
+    };
+
+    /// @brief Where the bars of a day are in an archive, also used to tell the days apart in a range read
+    struct BarArchiveDay
+    {
+        uint64_t date;
+        uint64_t firstBar;     // index of the first bar of the day
+        uint64_t barCount;
+    };
+
+    /// @brief Path of the archive of a symbol, next to its directory of .1m.bars files
+    std::string GetBarArchivePath(const std::string& symbol);
+
+    /// @brief Pack the .1m.bars files of a symbol into an archive
+    /// @param symbol
+    /// @param archivePath where to write the archive, usually GetBarArchivePath(symbol)
+    /// @param error set to the reason of the failure, if any
+    /// @return true if the archive was written, false otherwise
+    bool ConvertToBarArchive(const std::string& symbol, const std::string& archivePath, std::string& error);
+
+    /// @brief Read the bars of a range of days from the archive of a symbol with one allocation and one read
+    /// @param symbol
+    /// @param fromDate first date, included
+    /// @param toDate last date, included
+    /// @param bars the bars of the days in range, gets cleared in this function
+    /// @param days if not null, set to the days in range, firstBar being relative to bars.data
+    /// @return true if the archive could be read, false otherwise
+    bool ReadBarsRange(const std::string& symbol, uint64_t fromDate, uint64_t toDate, Bars& bars, std::vector<BarArchiveDay>* days = nullptr);
+
+    /// @brief Same as ReadBarsRange, from an archive at a given path
+    bool ReadBarsRangeFromArchive(const std::string& archivePath, uint64_t fromDate, uint64_t toDate, Bars& bars, std::vector<BarArchiveDay>* days = nullptr);
+}
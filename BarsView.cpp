@@ -0,0 +1,117 @@
+#include "BarsView.hpp"
+#include <iostream>
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+StockData::BarsView::BarsView(BarsView &&other) noexcept
+    : symbol(std::move(other.symbol)),
+      frequency(other.frequency),
+      mapping(other.mapping),
+      mappingSize(other.mappingSize),
+      payload(other.payload),
+      barCount(other.barCount)
+{
+    other.mapping = nullptr;
+    other.mappingSize = 0;
+    other.payload = nullptr;
+    other.barCount = 0;
+    other.frequency = DataFrequency::Undefined;
+}
+
+StockData::BarsView &StockData::BarsView::operator=(BarsView &&other) noexcept
+{
+    if (this != &other)
+    {
+        Close();
+        symbol = std::move(other.symbol);
+        frequency = other.frequency;
+        mapping = other.mapping;
+        mappingSize = other.mappingSize;
+        payload = other.payload;
+        barCount = other.barCount;
+
+        other.mapping = nullptr;
+        other.mappingSize = 0;
+        other.payload = nullptr;
+        other.barCount = 0;
+        other.frequency = DataFrequency::Undefined;
+    }
+    return *this;
+}
+
+StockData::BarsView::~BarsView()
+{
+    Close();
+}
+
+bool StockData::BarsView::Open(const std::string &filePath)
+{
+    Close();
+
+    int fd = open(filePath.c_str(), O_RDONLY | O_CLOEXEC);
+    if (fd < 0)
+    {
+        std::cerr << "Failed to open file: " << filePath << '\n';
+        return false;
+    }
+
+    struct stat fileStat;
+    if (fstat(fd, &fileStat) != 0 || static_cast<size_t>(fileStat.st_size) < StockData::BAR_INFO_SIZE)
+    {
+        std::cerr << "Invalid bars file: " << filePath << '\n';
+        close(fd);
+        return false;
+    }
+
+    size_t fileSize = fileStat.st_size;
+    void* address = mmap(nullptr, fileSize, PROT_READ, MAP_SHARED, fd, 0);
+    close(fd); // the mapping keeps its own reference to the file
+    if (address == MAP_FAILED)
+    {
+        std::cerr << "Failed to map file: " << filePath << '\n';
+        return false;
+    }
+    madvise(address, fileSize, MADV_SEQUENTIAL);
+
+    mapping = address;
+    mappingSize = fileSize;
+
+    const std::byte* bufferPos = static_cast<const std::byte*>(address);
+    symbol.assign(BARS_SYMBOL_SIZE + 1, '\0'); // +1 for null terminator, same as ReadBars
+    memcpy(symbol.data(), bufferPos, BARS_SYMBOL_SIZE);
+    bufferPos += BARS_SYMBOL_SIZE;
+
+    memcpy(&frequency, bufferPos, sizeof(DataFrequency));
+    bufferPos += sizeof(DataFrequency);
+
+    // a truncated .1m.bars may not even have room for the trailer
+    size_t dataSize = fileSize - BAR_INFO_SIZE >= sizeof(uint16_t) ? GetBarsDataSize(filePath, fileSize) : 0;
+    payload = bufferPos;
+    barCount = dataSize / sizeof(Bar);
+
+    return true;
+}
+
+void StockData::BarsView::Close()
+{
+    if (mapping != nullptr)
+    {
+        munmap(mapping, mappingSize);
+    }
+    mapping = nullptr;
+    mappingSize = 0;
+    payload = nullptr;
+    barCount = 0;
+    symbol.clear();
+    frequency = DataFrequency::Undefined;
+}
+
+void StockData::BarsView::ToBars(Bars &bars) const
+{
+    bars.symbol = symbol;
+    bars.frequency = frequency;
+    bars.data = std::vector<StockData::Bar>(barCount);
+    CopyTo(bars.data.data(), 0, barCount);
+}
@@ -0,0 +1,100 @@
+#pragma once
+#include <cstddef>
+#include <cstdint>
+#include <cstring>
+#include <iterator>
+#include <span>
+#include <string>
+
+#include "StockData.hpp"
+
+namespace StockData
+{
+    /// @brief Read-only view of a .1d.bars or .1m.bars file, backed by a shared memory mapping of the file.
+    /// The bar payload starts right after the 10 bytes header, so it is never aligned for Bar;
+    /// bars are therefore handed out by value instead of by reference.
+    struct BarsView
+    {
+        std::string symbol;
+        DataFrequency frequency = DataFrequency::Undefined;
+
+        struct Iterator
+        {
+            using iterator_category = std::random_access_iterator_tag;
+            using value_type = Bar;
+            using difference_type = std::ptrdiff_t;
+            using pointer = void;
+            using reference = Bar;
+
+            const std::byte* pos = nullptr;
+
+            Bar operator*() const
+            {
+                Bar bar;
+                memcpy(&bar, pos, sizeof(Bar));
+                return bar;
+            }
+
+            Bar operator[](difference_type n) const { return *(*this + n); }
+
+            Iterator& operator++() { pos += sizeof(Bar); return *this; }
+            Iterator operator++(int) { Iterator it = *this; pos += sizeof(Bar); return it; }
+            Iterator& operator--() { pos -= sizeof(Bar); return *this; }
+            Iterator operator--(int) { Iterator it = *this; pos -= sizeof(Bar); return it; }
+            Iterator& operator+=(difference_type n) { pos += n * static_cast<difference_type>(sizeof(Bar)); return *this; }
+            Iterator& operator-=(difference_type n) { pos -= n * static_cast<difference_type>(sizeof(Bar)); return *this; }
+            friend Iterator operator+(Iterator it, difference_type n) { return it += n; }
+            friend Iterator operator+(difference_type n, Iterator it) { return it += n; }
+            friend Iterator operator-(Iterator it, difference_type n) { return it -= n; }
+            friend difference_type operator-(const Iterator& a, const Iterator& b) { return (a.pos - b.pos) / static_cast<difference_type>(sizeof(Bar)); }
+            friend auto operator<=>(const Iterator& a, const Iterator& b) = default;
+        };
+
+        BarsView() = default;
+        BarsView(const BarsView&) = delete;
+        BarsView& operator=(const BarsView&) = delete;
+        BarsView(BarsView&& other) noexcept;
+        BarsView& operator=(BarsView&& other) noexcept;
+        ~BarsView();
+
+        /// @brief Maps a bars file, parsing the header the same way ReadBars does
+        /// @param filePath path of a .1d.bars or .1m.bars file
+        /// @return true if the file was mapped, false otherwise
+        bool Open(const std::string& filePath);
+
+        /// @brief Unmaps the file, the view is empty afterwards
+        void Close();
+
+        bool IsOpen() const { return mapping != nullptr; }
+        size_t size() const { return barCount; }
+        bool empty() const { return barCount == 0; }
+
+        Bar operator[](size_t i) const
+        {
+            Bar bar;
+            memcpy(&bar, payload + i * sizeof(Bar), sizeof(Bar));
+            return bar;
+        }
+
+        Iterator begin() const { return Iterator{payload}; }
+        Iterator end() const { return Iterator{payload + barCount * sizeof(Bar)}; }
+
+        /// @brief The raw bar payload as it is laid out in the file
+        std::span<const std::byte> Bytes() const { return {payload, barCount * sizeof(Bar)}; }
+
+        /// @brief Copies bars [first, first + count) into an aligned destination
+        void CopyTo(Bar* destination, size_t first, size_t count) const
+        {
+            memcpy(destination, payload + first * sizeof(Bar), count * sizeof(Bar));
+        }
+
+        /// @brief Materialises the view into an owning Bars
+        void ToBars(Bars& bars) const;
+
+    private:
+        void* mapping = nullptr;
+        size_t mappingSize = 0;
+        const std::byte* payload = nullptr;
+        size_t barCount = 0;
+    };
+}
@@ -0,0 +1,141 @@
+#include "BookFeatures.hpp"
+#include "Parallel.hpp"
+#include <algorithm>
+#include <limits>
+
+namespace
+{
+    using StockData::BOOK_LEVELS;
+    using StockData::BookFeature;
+    using StockData::BookFeatures;
+    using StockData::TickColumns;
+
+    constexpr double MISSING = std::numeric_limits<double>::quiet_NaN();
+
+    // The kernels are written as branch-free loops over the tick columns, so every level is processed
+    // for 4 (AVX2) or 2 (SSE2) ticks at once; target_clones picks the widest version the CPU supports
+
+    __attribute__((target_clones("avx2", "default")))
+    void ComputeLevelOneFeatures(const double* askPrice, const double* askVolume, const double* bidPrice, const double* bidVolume, size_t count,
+                                 double* midPrice, double* spread, double* microprice)
+    {
+        for (size_t i = 0; i < count; ++i)
+        {
+            bool twoSided = askPrice[i] > 0.0 && bidPrice[i] > 0.0;
+            double volume = askVolume[i] + bidVolume[i];
+            midPrice[i] = twoSided ? 0.5 * (askPrice[i] + bidPrice[i]) : MISSING;
+            spread[i] = twoSided ? askPrice[i] - bidPrice[i] : MISSING;
+            microprice[i] = twoSided && volume > 0.0 ? (askPrice[i] * bidVolume[i] + bidPrice[i] * askVolume[i]) / volume : MISSING;
+        }
+    }
+
+    __attribute__((target_clones("avx2", "default")))
+    void AccumulateDepth(const double* price, const double* volume, size_t count, double* depth, double* notional)
+    {
+        for (size_t i = 0; i < count; ++i)
+        {
+            depth[i] += volume[i];
+            notional[i] += price[i] * volume[i];
+        }
+    }
+
+    __attribute__((target_clones("avx2", "default")))
+    void ComputeDepthFeatures(const double* askDepth, const double* askNotional, const double* bidDepth, const double* bidNotional, size_t count,
+                              double* imbalance, double* weightedSpread)
+    {
+        for (size_t i = 0; i < count; ++i)
+        {
+            double depth = bidDepth[i] + askDepth[i];
+            imbalance[i] = depth > 0.0 ? (bidDepth[i] - askDepth[i]) / depth : MISSING;
+            weightedSpread[i] = askDepth[i] > 0.0 && bidDepth[i] > 0.0 ? askNotional[i] / askDepth[i] - bidNotional[i] / bidDepth[i] : MISSING;
+        }
+    }
+
+    /// @brief Add the order flow of one level between consecutive ticks, for ticks [1, count).
+    /// An empty level (price 0) has no queue: a level that empties removes its previous queue, one that fills adds its new one
+    /// @param improves true for the bid side, where a higher price is an improvement
+    __attribute__((target_clones("avx2", "default")))
+    void AccumulateQueueChange(const double* price, const double* volume, size_t count, bool improves, double* change)
+    {
+        const double direction = improves ? 1.0 : -1.0;
+        for (size_t i = 1; i < count; ++i)
+        {
+            bool wasQuoted = price[i - 1] > 0.0;
+            bool isQuoted = price[i] > 0.0;
+            double move = (price[i] - price[i - 1]) * direction;
+            double added = isQuoted && (!wasQuoted || move >= 0.0) ? volume[i] : 0.0;
+            double removed = wasQuoted && (!isQuoted || move <= 0.0) ? volume[i - 1] : 0.0;
+            change[i] += added - removed;
+        }
+    }
+
+    __attribute__((target_clones("avx2", "default")))
+    void Subtract(const double* a, const double* b, size_t count, double* result)
+    {
+        for (size_t i = 0; i < count; ++i)
+        {
+            result[i] = a[i] - b[i];
+        }
+    }
+}
+
+void StockData::ComputeBookFeatures(const TickColumns &ticks, BookFeatures &features)
+{
+    const size_t count = ticks.size();
+    features.Resize(count);
+    if (count == 0)
+    {
+        return;
+    }
+
+    ComputeLevelOneFeatures(ticks.AskPrices(0), ticks.AskVolumes(0), ticks.BidPrices(0), ticks.BidVolumes(0), count,
+                            features.Column(BookFeature::MidPrice), features.Column(BookFeature::Spread), features.Column(BookFeature::Microprice));
+
+    std::vector<double> askDepth(count, 0.0), askNotional(count, 0.0), bidDepth(count, 0.0), bidNotional(count, 0.0);
+    double* bidChange = features.Column(BookFeature::BidQueueChange);
+    double* askChange = features.Column(BookFeature::AskQueueChange);
+    std::fill(bidChange, bidChange + count, 0.0);
+    std::fill(askChange, askChange + count, 0.0);
+    for (size_t level = 0; level < BOOK_LEVELS; ++level)
+    {
+        AccumulateDepth(ticks.AskPrices(level), ticks.AskVolumes(level), count, askDepth.data(), askNotional.data());
+        AccumulateDepth(ticks.BidPrices(level), ticks.BidVolumes(level), count, bidDepth.data(), bidNotional.data());
+        AccumulateQueueChange(ticks.BidPrices(level), ticks.BidVolumes(level), count, true, bidChange);
+        AccumulateQueueChange(ticks.AskPrices(level), ticks.AskVolumes(level), count, false, askChange);
+    }
+
+    ComputeDepthFeatures(askDepth.data(), askNotional.data(), bidDepth.data(), bidNotional.data(), count,
+                         features.Column(BookFeature::DepthImbalance), features.Column(BookFeature::DepthWeightedSpread));
+    Subtract(bidChange, askChange, count, features.Column(BookFeature::OrderFlowImbalance));
+}
+
+void StockData::ComputeBookFeatures(const Ticks &ticks, BookFeatures &features)
+{
+    ComputeBookFeatures(TickColumns(ticks), features);
+}
+
+void StockData::ComputeBookFeatures(const std::vector<SymbolDay> &days, size_t threads, std::vector<BookFeatures> &features, std::vector<LoadFailure> &failures)
+{
+    features.clear();
+    features.resize(days.size());
+    failures.clear();
+
+    std::vector<char> loaded(days.size(), 0); // not vector<bool>, workers write neighbouring elements
+    ParallelFor(days.size(), threads, [&](size_t i)
+    {
+        TickColumns ticks;
+        if (ticks.Load(GetFilePath(days[i].symbol, DataFrequency::Tick, days[i].date)))
+        {
+            ComputeBookFeatures(ticks, features[i]);
+            loaded[i] = 1;
+        }
+    });
+
+    for (size_t i = 0; i < days.size(); ++i)
+    {
+        if (!loaded[i])
+        {
+            failures.push_back(LoadFailure{i, GetFilePath(days[i].symbol, DataFrequency::Tick, days[i].date), "Failed to load ticks"});
+        }
+    }
+}
@@ -0,0 +1,70 @@
+#pragma once
+#include <cstddef>
+#include <cstdint>
+#include <string>
+#include <vector>
+
+#include "StockData.hpp"
+#include "TickColumns.hpp"
+#include "Universe.hpp"
+
+namespace StockData
+{
+    /// @brief Per-tick order book features, see ComputeBookFeatures
+    enum class BookFeature
+    {
+        MidPrice = 0,        // (ask1 + bid1) / 2
+        Spread,              // ask1 - bid1
+        Microprice,          // (ask1 * bidVolume1 + bid1 * askVolume1) / (askVolume1 + bidVolume1)
+        DepthImbalance,      // (bid depth - ask depth) / (bid depth + ask depth), over the 5 levels
+        DepthWeightedSpread, // volume weighted ask price minus volume weighted bid price, over the 5 levels
+        BidQueueChange,      // bid side order flow since the previous tick, summed over the 5 levels
+        AskQueueChange,      // ask side order flow since the previous tick, summed over the 5 levels
+        OrderFlowImbalance,  // BidQueueChange - AskQueueChange
+        Count
+    };
+
+    /// @brief One column per feature, one value per tick. Features that need both sides of the book
+    /// are NaN when a side is empty (e.g. no asks at the limit up), queue changes are 0 for the first tick.
+    /// A level that empties counts as its whole queue leaving, a level that gets quoted again as its whole queue arriving
+    struct BookFeatures
+    {
+        static constexpr size_t FEATURE_COUNT = static_cast<size_t>(BookFeature::Count);
+
+        std::vector<double> columns[FEATURE_COUNT];
+
+        size_t size() const { return columns[0].size(); }
+
+        const double* Column(BookFeature feature) const { return columns[static_cast<size_t>(feature)].data(); }
+        double* Column(BookFeature feature) { return columns[static_cast<size_t>(feature)].data(); }
+
+        void Resize(size_t count)
+        {
+            for (auto& column : columns)
+            {
+                column.resize(count);
+            }
+        }
+    };
+
+    struct SymbolDay
+    {
+        std::string symbol;
+        uint64_t date;
+    };
+
+    /// @brief Compute the book features of a day of ticks.
+    /// Queue changes follow the order flow imbalance of Cont, Kukanov and Stoikov, applied to each of the 5 levels:
+    /// a level whose price improved contributes its new volume, one whose price worsened its old volume with a minus sign,
+    /// and one whose price did not move the change of its volume
+    void ComputeBookFeatures(const TickColumns& ticks, BookFeatures& features);
+
+    /// @brief Same as above for ticks read by ReadTicks, which are transposed into columns first
+    void ComputeBookFeatures(const Ticks& ticks, BookFeatures& features);
+
+    /// @brief Load the ticks of many symbol-days and compute their book features on a pool of worker threads
+    /// @param features one per symbol-day, empty where the ticks could not be loaded
+    /// @param failures the symbol-days that could not be loaded, symbolIndex is the index in days
+    /// @param threads number of worker threads, 0 for one per hardware thread
+    void ComputeBookFeatures(const std::vector<SymbolDay>& days, size_t threads, std::vector<BookFeatures>& features, std::vector<LoadFailure>& failures);
+}
@@ -0,0 +1,287 @@
+#include "CompactRecords.hpp"
+#include "BarsView.hpp"
+#include "TickStream.hpp"
+#include <chrono>
+#include <cmath>
+#include <cstring>
+#include <limits>
+
+namespace
+{
+    constexpr uint32_t MINUTE_TIME_FLAG = 0x80000000u;
+    constexpr std::chrono::sys_days MINUTE_TIME_EPOCH = std::chrono::sys_days{std::chrono::year{1990} / 1 / 1};
+
+    /// @brief Scale a value to an integer number of units (100 for fen, 1 for shares) within [minimum, maximum]
+    template <typename Integer>
+    bool ToUnits(double value, double unitsPerValue, bool allowRounding, Integer& units)
+    {
+        if (!std::isfinite(value))
+        {
+            return false;
+        }
+        // max() + 1 is a power of two, so it is exact as a double, unlike max() which rounds up to 2^63 for int64_t
+        const double end = std::ldexp(1.0, std::numeric_limits<Integer>::digits);
+        double scaled = std::nearbyint(value * unitsPerValue);
+        if (scaled < static_cast<double>(std::numeric_limits<Integer>::min()) || scaled >= end)
+        {
+            return false;
+        }
+        units = static_cast<Integer>(scaled);
+        return allowRounding || units / unitsPerValue == value;
+    }
+
+    template <typename Integer>
+    bool ToFen(double value, bool allowRounding, Integer& fen)
+    {
+        return ToUnits(value, 100.0, allowRounding, fen);
+    }
+
+    template <typename Integer>
+    bool ToShares(double value, bool allowRounding, Integer& shares)
+    {
+        return ToUnits(value, 1.0, allowRounding, shares);
+    }
+
+    bool ToCompactBarFields(uint64_t time, double open, double high, double low, double close, double volume, double amount,
+                            StockData::CompactBar& compact, bool allowRounding)
+    {
+        return StockData::EncodeCompactTime(time, compact.time)
+            && ToFen(open, allowRounding, compact.open)
+            && ToFen(high, allowRounding, compact.high)
+            && ToFen(low, allowRounding, compact.low)
+            && ToFen(close, allowRounding, compact.close)
+            && ToShares(volume, allowRounding, compact.volume)
+            && ToFen(amount, allowRounding, compact.amount);
+    }
+}
+
+bool StockData::EncodeCompactTime(uint64_t time, uint32_t &compactTime)
+{
+    if (time < MINUTE_TIME_FLAG)
+    {
+        compactTime = static_cast<uint32_t>(time);
+        return true;
+    }
+
+    // YYYYMMDDHHMMSS
+    uint64_t date = time / 1000000;
+    uint64_t timeOfDay = time % 1000000;
+    std::chrono::year_month_day day{std::chrono::year(static_cast<int>(date / 10000)),
+                                    std::chrono::month(static_cast<unsigned>(date / 100 % 100)),
+                                    std::chrono::day(static_cast<unsigned>(date % 100))};
+    uint64_t hours = timeOfDay / 10000, minutes = timeOfDay / 100 % 100, seconds = timeOfDay % 100;
+    if (date / 10000 > 9999 || !day.ok() || hours >= 24 || minutes >= 60 || seconds != 0 || std::chrono::sys_days{day} < MINUTE_TIME_EPOCH)
+    {
+        return false;
+    }
+
+    uint64_t days = (std::chrono::sys_days{day} - MINUTE_TIME_EPOCH).count();
+    uint64_t minutesSinceEpoch = days * 1440 + hours * 60 + minutes;
+    if (minutesSinceEpoch >= MINUTE_TIME_FLAG)
+    {
+        return false;
+    }
+    compactTime = MINUTE_TIME_FLAG | static_cast<uint32_t>(minutesSinceEpoch);
+    return true;
+}
+
+uint64_t StockData::DecodeCompactTime(uint32_t compactTime)
+{
+    if ((compactTime & MINUTE_TIME_FLAG) == 0)
+    {
+        return compactTime;
+    }
+
+    uint32_t minutesSinceEpoch = compactTime & ~MINUTE_TIME_FLAG;
+    std::chrono::year_month_day day{MINUTE_TIME_EPOCH + std::chrono::days(minutesSinceEpoch / 1440)};
+    uint64_t minuteOfDay = minutesSinceEpoch % 1440;
+    uint64_t date = static_cast<uint64_t>(static_cast<int>(day.year())) * 10000 + static_cast<unsigned>(day.month()) * 100 + static_cast<unsigned>(day.day());
+    return date * 1000000 + (minuteOfDay / 60) * 10000 + (minuteOfDay % 60) * 100;
+}
+
+bool StockData::ToCompactBar(const Bar &bar, CompactBar &compact, bool allowRounding)
+{
+    return ToCompactBarFields(bar.time, bar.open, bar.high, bar.low, bar.close, bar.volume, bar.amount, compact, allowRounding);
+}
+
+bool StockData::ToCompactBar(const AugmentedBar &bar, CompactBar &compact, bool allowRounding)
+{
+    return ToCompactBarFields(bar.time, bar.open, bar.high, bar.low, bar.close, bar.volume, bar.amount, compact, allowRounding);
+}
+
+bool StockData::ToCompactTick(const Tick &tick, CompactTick &compact, bool allowRounding)
+{
+    if (!EncodeCompactTime(tick.time, compact.time)
+        || !ToFen(tick.price, allowRounding, compact.price)
+        || !ToShares(tick.transactionCount, allowRounding, compact.transactionCount)
+        || !ToShares(tick.tickVolume, allowRounding, compact.tickVolume)
+        || !ToFen(tick.tickAmount, allowRounding, compact.tickAmount)
+        || !ToShares(tick.dayVolume, allowRounding, compact.dayVolume)
+        || !ToFen(tick.dayAmount, allowRounding, compact.dayAmount))
+    {
+        return false;
+    }
+    for (size_t level = 0; level < 5; ++level)
+    {
+        if (!ToShares(tick.askVolumes[level], allowRounding, compact.askVolumes[level])
+            || !ToFen(tick.askPrices[level], allowRounding, compact.askPrices[level])
+            || !ToShares(tick.bidVolumes[level], allowRounding, compact.bidVolumes[level])
+            || !ToFen(tick.bidPrices[level], allowRounding, compact.bidPrices[level]))
+        {
+            return false;
+        }
+    }
+    return true;
+}
+
+StockData::Bar StockData::ToBar(const CompactBar &compact)
+{
+    return Bar{DecodeCompactTime(compact.time), FromFen(compact.open), FromFen(compact.high), FromFen(compact.low),
+               FromFen(compact.close), static_cast<double>(compact.volume), FromFen(compact.amount)};
+}
+
+StockData::Tick StockData::ToTick(const CompactTick &compact)
+{
+    Tick tick;
+    tick.time = DecodeCompactTime(compact.time);
+    tick.price = FromFen(compact.price);
+    tick.transactionCount = compact.transactionCount;
+    tick.tickVolume = compact.tickVolume;
+    tick.tickAmount = FromFen(compact.tickAmount);
+    tick.dayVolume = static_cast<double>(compact.dayVolume);
+    tick.dayAmount = FromFen(compact.dayAmount);
+    for (size_t level = 0; level < 5; ++level)
+    {
+        tick.askVolumes[level] = compact.askVolumes[level];
+        tick.askPrices[level] = FromFen(compact.askPrices[level]);
+        tick.bidVolumes[level] = compact.bidVolumes[level];
+        tick.bidPrices[level] = FromFen(compact.bidPrices[level]);
+    }
+    return tick;
+}
+
+StockData::AugmentedBar StockData::ToAugmentedBar(const CompactBar &compact)
+{
+    Bar bar = ToBar(compact);
+    return AugmentedBar{
+        time: bar.time,
+        open: bar.open,
+        openNormalized: 0.0,
+        high: bar.high,
+        highNormalized: 0.0,
+        low: bar.low,
+        lowNormalized: 0.0,
+        close: bar.close,
+        closeNormalized: 0.0,
+        average: (bar.amount / bar.volume),
+        averageNormalized: 0.0,
+        volume: bar.volume,
+        volumeNormalized: 0.0,
+        amount: bar.amount,
+        amountNormalized: 0.0,
+        barDistance: 0.0,
+        HasDistances: 0
+    };
+}
+
+bool StockData::ToCompactBars(const Bars &bars, CompactBars &compact, std::string &error, bool allowRounding)
+{
+    compact.symbol = bars.symbol;
+    compact.frequency = bars.frequency;
+    compact.data.resize(bars.data.size());
+    for (size_t i = 0; i < bars.data.size(); ++i)
+    {
+        if (!ToCompactBar(bars.data[i], compact.data[i], allowRounding))
+        {
+            error = "Bar " + std::to_string(i) + " cannot be represented as a compact bar";
+            compact.data.clear();
+            return false;
+        }
+    }
+    return true;
+}
+
+void StockData::ToBars(const CompactBars &compact, Bars &bars)
+{
+    bars.symbol = compact.symbol;
+    bars.frequency = compact.frequency;
+    bars.data.resize(compact.data.size());
+    for (size_t i = 0; i < compact.data.size(); ++i)
+    {
+        bars.data[i] = ToBar(compact.data[i]);
+    }
+}
+
+void StockData::ToAugmentedBars(const CompactBars &compact, AugmentedBars &bars)
+{
+    bars.symbol = compact.symbol;
+    bars.symbol.resize(6, '\0'); // same as AugmentedBars(const Bars&)
+    bars.frequency = compact.frequency;
+    bars.averageDistance = 0.0;
+    bars.data.resize(compact.data.size());
+    for (size_t i = 0; i < compact.data.size(); ++i)
+    {
+        bars.data[i] = ToAugmentedBar(compact.data[i]);
+    }
+}
+
+bool StockData::ReadCompactBars(const std::string &filePath, CompactBars &bars, std::string &error, bool allowRounding)
+{
+    bars.data.clear();
+    BarsView view;
+    if (!view.Open(filePath))
+    {
+        error = "Failed to open file: " + filePath;
+        return false;
+    }
+
+    bars.symbol = view.symbol;
+    bars.frequency = view.frequency;
+    bars.data.resize(view.size());
+    for (size_t i = 0; i < view.size(); ++i)
+    {
+        if (!ToCompactBar(view[i], bars.data[i], allowRounding))
+        {
+            error = "Bar " + std::to_string(i) + " of " + filePath + " cannot be represented as a compact bar";
+            bars.data.clear();
+            return false;
+        }
+    }
+    return true;
+}
+
+bool StockData::ReadCompactTicks(const std::string &filePath, CompactTicks &ticks, std::string &error, bool allowRounding)
+{
+    ticks.data.clear();
+    TickStream stream;
+    if (!stream.Open(filePath))
+    {
+        error = "Failed to open file: " + filePath;
+        return false;
+    }
+
+    memcpy(ticks.symbol, stream.symbol, SYMBOL_SIZE);
+    ticks.date = stream.date;
+    ticks.data.resize(stream.Remaining());
+    size_t count = 0;
+    for (auto batch = stream.NextBatch(); !batch.empty(); batch = stream.NextBatch())
+    {
+        for (const Tick& tick : batch)
+        {
+            if (!ToCompactTick(tick, ticks.data[count], allowRounding))
+            {
+                error = "Tick " + std::to_string(count) + " of " + filePath + " cannot be represented as a compact tick";
+                ticks.data.clear();
+                return false;
+            }
+            ++count;
+        }
+    }
+    if (count != ticks.data.size())
+    {
+        error = "Failed to read ticks: " + filePath;
+        ticks.data.clear();
+        return false;
+    }
+    return true;
+}
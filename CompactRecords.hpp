@@ -0,0 +1,110 @@
+#pragma once
+#include <cstddef>
+#include <cstdint>
+#include <string>
+#include <vector>
+
+#include "Indicators.hpp"
+#include "StockData.hpp"
+
+namespace StockData
+{
+    // Compact records store prices and amounts in fen (0.01 CNY), volumes in shares, and times in 32 bits.
+    // Times below 2^31 (YYYYMMDD dates, HHMMSS times of day) are stored as is. Intraday bar times
+    // (YYYYMMDDHHMMSS, see Aggregation.hpp) are stored as minutes since 1990-01-01 with the top bit set,
+    // which only works for times on a whole minute.
+    // Converting to a compact record fails when a value does not survive the round trip, unless rounding is allowed
+
+    /// @brief Bar in 32 bytes instead of 56
+    struct CompactBar
+    {
+        uint32_t time;
+        int32_t open;   // fen
+        int32_t high;
+        int32_t low;
+        int32_t close;
+        uint32_t volume;
+        int64_t amount; // fen
+    };
+    static_assert(sizeof(CompactBar) == 32);
+
+    /// @brief Tick in 120 bytes instead of 216
+    struct CompactTick
+    {
+        uint32_t time;
+        int32_t price;  // fen
+        uint32_t transactionCount;
+        uint32_t tickVolume;
+        int64_t tickAmount; // fen
+        int64_t dayVolume;
+        int64_t dayAmount;  // fen
+        uint32_t askVolumes[5];
+        int32_t askPrices[5];
+        uint32_t bidVolumes[5];
+        int32_t bidPrices[5];
+    };
+    static_assert(sizeof(CompactTick) == 120);
+
+    struct CompactBars
+    {
+        std::string symbol;
+        DataFrequency frequency = DataFrequency::Undefined;
+        std::vector<CompactBar> data;
+    };
+
+    struct CompactTicks
+    {
+        char symbol[SYMBOL_SIZE] = {};
+        uint64_t date = 0;
+        std::vector<CompactTick> data;
+    };
+
+    /// @brief Encode a bar or tick time in 32 bits, see above
+    /// @return false if the time cannot be represented
+    bool EncodeCompactTime(uint64_t time, uint32_t& compactTime);
+    uint64_t DecodeCompactTime(uint32_t compactTime);
+
+    constexpr double FromFen(int64_t fen) { return fen / 100.0; }
+
+    /// @param allowRounding round values to the nearest fen or share instead of failing
+    /// @return false if a value cannot be represented, compact is then undefined
+    bool ToCompactBar(const Bar& bar, CompactBar& compact, bool allowRounding = false);
+    bool ToCompactBar(const AugmentedBar& bar, CompactBar& compact, bool allowRounding = false);
+    bool ToCompactTick(const Tick& tick, CompactTick& compact, bool allowRounding = false);
+
+    Bar ToBar(const CompactBar& compact);
+    Tick ToTick(const CompactTick& compact);
+
+    /// @brief Augmented bar with average = amount / volume and the normalized fields zeroed, like AugmentedBars(const Bars&)
+    AugmentedBar ToAugmentedBar(const CompactBar& compact);
+
+    /// @brief Convert a whole series
+    /// @param error set to the first bar that cannot be represented, if any
+    /// @return true if every bar was converted, false otherwise
+    bool ToCompactBars(const Bars& bars, CompactBars& compact, std::string& error, bool allowRounding = false);
+    void ToBars(const CompactBars& compact, Bars& bars);
+    void ToAugmentedBars(const CompactBars& compact, AugmentedBars& bars);
+
+    /// @brief Load a .1d.bars or .1m.bars file straight into compact bars, through a BarsView
+    /// @return true if the file was read and every bar converted, false otherwise
+    bool ReadCompactBars(const std::string& filePath, CompactBars& bars, std::string& error, bool allowRounding = false);
+
+    /// @brief Load a tick file straight into compact ticks, one TickStream chunk at a time
+    /// @return true if the file was read and every tick converted, false otherwise
+    bool ReadCompactTicks(const std::string& filePath, CompactTicks& ticks, std::string& error, bool allowRounding = false);
+
+    /// @brief Field of a compact bar in CNY and shares, so the templated indicator kernels run on compact bars as well
+    inline double GetBarField(const CompactBar& bar, BarField field)
+    {
+        switch (field)
+        {
+            case BarField::Open: return FromFen(bar.open);
+            case BarField::High: return FromFen(bar.high);
+            case BarField::Low: return FromFen(bar.low);
+            case BarField::Close: return FromFen(bar.close);
+            case BarField::Volume: return bar.volume;
+            case BarField::Amount: return FromFen(bar.amount);
+        }
+        return 0.0;
+    }
+}
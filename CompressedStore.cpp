@@ -0,0 +1,625 @@
+#include "CompressedStore.hpp"
+#include <algorithm>
+#include <bit>
+#include <cmath>
+#include <fstream>
+#include <iostream>
+#include <vector>
+
+namespace
+{
+    using StockData::CompressedBlockInfo;
+    using StockData::CompressedHeader;
+    using StockData::CompressedKind;
+
+    constexpr char COMPRESSED_MAGIC[4] = {'S', 'D', 'C', 'Z'};
+    constexpr size_t BAR_FIELDS = sizeof(StockData::Bar) / sizeof(uint64_t);
+    constexpr size_t TICK_FIELDS = sizeof(StockData::Tick) / sizeof(uint64_t);
+    static_assert(BAR_FIELDS * sizeof(uint64_t) == sizeof(StockData::Bar), "Bar must be made of 8 bytes fields");
+    static_assert(TICK_FIELDS * sizeof(uint64_t) == sizeof(StockData::Tick), "Tick must be made of 8 bytes fields");
+    static_assert(TICK_FIELDS == StockData::TickColumns::COLUMN_COUNT, "TickColumns must have one column per Tick field");
+
+    enum class ColumnCodec : uint8_t
+    {
+        Time = 0,    // uint64_t, varint of zigzag deltas
+        Integer = 1, // doubles holding integers, varint of zigzag deltas
+        Decimal = 2, // doubles holding hundredths, varint of zigzag deltas of value * 100
+        Xor = 3      // any double, Gorilla-style XOR with the previous value
+    };
+
+    constexpr double MAX_EXACT_INTEGER = 9007199254740992.0; // 2^53
+
+    /// @brief Where decoded values of a field go: base + i * stride for the i-th record
+    struct FieldTarget
+    {
+        std::byte* base;
+        size_t stride;
+    };
+
+    uint64_t ZigZag(uint64_t delta) { return (delta << 1) ^ static_cast<uint64_t>(static_cast<int64_t>(delta) >> 63); }
+    uint64_t UnZigZag(uint64_t value) { return (value >> 1) ^ (~(value & 1) + 1); }
+
+    void PutVarint(std::vector<uint8_t>& out, uint64_t value)
+    {
+        while (value >= 0x80)
+        {
+            out.push_back(static_cast<uint8_t>(value) | 0x80);
+            value >>= 7;
+        }
+        out.push_back(static_cast<uint8_t>(value));
+    }
+
+    bool GetVarint(const uint8_t*& pos, const uint8_t* end, uint64_t& value)
+    {
+        value = 0;
+        for (int shift = 0; shift < 64 && pos < end; shift += 7)
+        {
+            uint8_t byte = *pos++;
+            value |= static_cast<uint64_t>(byte & 0x7f) << shift;
+            if ((byte & 0x80) == 0)
+            {
+                return true;
+            }
+        }
+        return false;
+    }
+
+    struct BitWriter
+    {
+        std::vector<uint8_t>& out;
+        uint64_t pending = 0;
+        int pendingBits = 0;
+
+        void Write(uint64_t value, int bits)
+        {
+            if (bits > 32)
+            {
+                Write(value >> 32, bits - 32);
+                Write(value & 0xffffffffULL, 32);
+                return;
+            }
+            pending = (pending << bits) | (value & ((1ULL << bits) - 1));
+            pendingBits += bits;
+            while (pendingBits >= 8)
+            {
+                pendingBits -= 8;
+                out.push_back(static_cast<uint8_t>(pending >> pendingBits));
+            }
+            pending &= (1ULL << pendingBits) - 1;
+        }
+
+        void Flush()
+        {
+            if (pendingBits > 0)
+            {
+                out.push_back(static_cast<uint8_t>(pending << (8 - pendingBits)));
+                pending = 0;
+                pendingBits = 0;
+            }
+        }
+    };
+
+    struct BitReader
+    {
+        const uint8_t* pos;
+        const uint8_t* end;
+        uint64_t pending = 0;
+        int pendingBits = 0;
+        bool overrun = false;
+
+        uint64_t Read(int bits)
+        {
+            if (bits > 32)
+            {
+                uint64_t high = Read(bits - 32);
+                return (high << 32) | Read(32);
+            }
+            while (pendingBits < bits)
+            {
+                overrun |= pos >= end;
+                pending = (pending << 8) | (pos < end ? *pos++ : 0);
+                pendingBits += 8;
+            }
+            pendingBits -= bits;
+            uint64_t value = (pending >> pendingBits) & ((1ULL << bits) - 1);
+            pending &= (1ULL << pendingBits) - 1;
+            return value;
+        }
+    };
+
+    uint64_t LoadBits(const std::byte* address)
+    {
+        uint64_t bits;
+        memcpy(&bits, address, sizeof(bits));
+        return bits;
+    }
+
+    void StoreBits(std::byte* address, uint64_t bits)
+    {
+        memcpy(address, &bits, sizeof(bits));
+    }
+
+    double BitsToDouble(uint64_t bits) { return std::bit_cast<double>(bits); }
+
+    bool IsExactInteger(double value)
+    {
+        return std::isfinite(value) && std::fabs(value) < MAX_EXACT_INTEGER && std::trunc(value) == value
+            && !(value == 0.0 && std::signbit(value));
+    }
+
+    bool IsExactDecimal(double value, int64_t& hundredths)
+    {
+        if (!std::isfinite(value) || std::fabs(value) * 100.0 >= MAX_EXACT_INTEGER)
+        {
+            return false;
+        }
+        hundredths = std::llround(value * 100.0);
+        return std::bit_cast<uint64_t>(static_cast<double>(hundredths) / 100.0) == std::bit_cast<uint64_t>(value);
+    }
+
+    ColumnCodec ChooseCodec(const std::vector<uint64_t>& column)
+    {
+        bool integers = true;
+        bool decimals = true;
+        for (uint64_t bits : column)
+        {
+            double value = BitsToDouble(bits);
+            int64_t hundredths;
+            integers = integers && IsExactInteger(value);
+            decimals = decimals && IsExactDecimal(value, hundredths);
+            if (!integers && !decimals)
+            {
+                return ColumnCodec::Xor;
+            }
+        }
+        return integers ? ColumnCodec::Integer : ColumnCodec::Decimal;
+    }
+
+    void EncodeDeltas(const std::vector<uint64_t>& column, ColumnCodec codec, std::vector<uint8_t>& out)
+    {
+        uint64_t previous = 0;
+        for (uint64_t bits : column)
+        {
+            uint64_t value = bits;
+            if (codec == ColumnCodec::Integer)
+            {
+                value = static_cast<uint64_t>(static_cast<int64_t>(BitsToDouble(bits)));
+            }
+            else if (codec == ColumnCodec::Decimal)
+            {
+                value = static_cast<uint64_t>(std::llround(BitsToDouble(bits) * 100.0));
+            }
+            PutVarint(out, ZigZag(value - previous));
+            previous = value;
+        }
+    }
+
+    void EncodeXor(const std::vector<uint64_t>& column, std::vector<uint8_t>& out)
+    {
+        BitWriter writer{out};
+        writer.Write(column[0], 64);
+        int windowLeading = -1, windowTrailing = 0;
+        for (size_t i = 1; i < column.size(); ++i)
+        {
+            uint64_t difference = column[i] ^ column[i - 1];
+            if (difference == 0)
+            {
+                writer.Write(0, 1);
+                continue;
+            }
+
+            int leading = std::countl_zero(difference);
+            int trailing = std::countr_zero(difference);
+            if (windowLeading >= 0 && leading >= windowLeading && trailing >= windowTrailing)
+            {
+                // fits in the previous window of meaningful bits
+                writer.Write(0b10, 2);
+                writer.Write(difference >> windowTrailing, 64 - windowLeading - windowTrailing);
+            }
+            else
+            {
+                int meaningful = 64 - leading - trailing;
+                writer.Write(0b11, 2);
+                writer.Write(leading, 6);
+                writer.Write(meaningful - 1, 6);
+                writer.Write(difference >> trailing, meaningful);
+                windowLeading = leading;
+                windowTrailing = trailing;
+            }
+        }
+        writer.Flush();
+    }
+
+    bool DecodeDeltas(const uint8_t* pos, const uint8_t* end, ColumnCodec codec, size_t count, const FieldTarget& target)
+    {
+        uint64_t value = 0;
+        for (size_t i = 0; i < count; ++i)
+        {
+            uint64_t delta;
+            if (!GetVarint(pos, end, delta))
+            {
+                return false;
+            }
+            value += UnZigZag(delta);
+
+            uint64_t bits = value;
+            if (codec == ColumnCodec::Integer)
+            {
+                bits = std::bit_cast<uint64_t>(static_cast<double>(static_cast<int64_t>(value)));
+            }
+            else if (codec == ColumnCodec::Decimal)
+            {
+                bits = std::bit_cast<uint64_t>(static_cast<double>(static_cast<int64_t>(value)) / 100.0);
+            }
+            StoreBits(target.base + i * target.stride, bits);
+        }
+        return pos == end;
+    }
+
+    bool DecodeXor(const uint8_t* pos, const uint8_t* end, size_t count, const FieldTarget& target)
+    {
+        BitReader reader{pos, end};
+        uint64_t value = reader.Read(64);
+        StoreBits(target.base, value);
+        int windowLeading = 0, windowTrailing = 0;
+        for (size_t i = 1; i < count; ++i)
+        {
+            if (reader.Read(1) != 0)
+            {
+                if (reader.Read(1) != 0)
+                {
+                    windowLeading = static_cast<int>(reader.Read(6));
+                    int meaningful = static_cast<int>(reader.Read(6)) + 1;
+                    windowTrailing = 64 - windowLeading - meaningful;
+                    if (windowTrailing < 0)
+                    {
+                        return false;
+                    }
+                }
+                value ^= reader.Read(64 - windowLeading - windowTrailing) << windowTrailing;
+            }
+            StoreBits(target.base + i * target.stride, value);
+        }
+        return !reader.overrun;
+    }
+
+    /// @brief Encode count records of fieldCount 8 bytes fields each, field 0 being the time
+    void EncodeBlock(const std::byte* records, size_t fieldCount, size_t count, std::vector<uint8_t>& out)
+    {
+        const size_t recordSize = fieldCount * sizeof(uint64_t);
+        std::vector<uint64_t> column(count);
+        std::vector<uint8_t> payload;
+        for (size_t field = 0; field < fieldCount; ++field)
+        {
+            for (size_t i = 0; i < count; ++i)
+            {
+                column[i] = LoadBits(records + i * recordSize + field * sizeof(uint64_t));
+            }
+
+            ColumnCodec codec = field == 0 ? ColumnCodec::Time : ChooseCodec(column);
+            payload.clear();
+            if (codec == ColumnCodec::Xor)
+            {
+                EncodeXor(column, payload);
+            }
+            else
+            {
+                EncodeDeltas(column, codec, payload);
+            }
+
+            uint32_t payloadSize = payload.size();
+            out.push_back(static_cast<uint8_t>(codec));
+            out.insert(out.end(), reinterpret_cast<const uint8_t*>(&payloadSize), reinterpret_cast<const uint8_t*>(&payloadSize) + sizeof(payloadSize));
+            out.insert(out.end(), payload.begin(), payload.end());
+        }
+    }
+
+    bool DecodeBlock(const std::vector<uint8_t>& block, size_t count, const std::vector<FieldTarget>& targets, size_t first)
+    {
+        const uint8_t* pos = block.data();
+        const uint8_t* end = block.data() + block.size();
+        for (const FieldTarget& fieldTarget : targets)
+        {
+            uint32_t payloadSize;
+            if (end - pos < static_cast<long>(1 + sizeof(payloadSize)))
+            {
+                return false;
+            }
+            ColumnCodec codec = static_cast<ColumnCodec>(*pos++);
+            memcpy(&payloadSize, pos, sizeof(payloadSize));
+            pos += sizeof(payloadSize);
+            if (end - pos < static_cast<long>(payloadSize))
+            {
+                return false;
+            }
+
+            FieldTarget target{fieldTarget.base + first * fieldTarget.stride, fieldTarget.stride};
+            bool decoded = codec == ColumnCodec::Xor
+                ? DecodeXor(pos, pos + payloadSize, count, target)
+                : codec <= ColumnCodec::Decimal && DecodeDeltas(pos, pos + payloadSize, codec, count, target);
+            if (!decoded)
+            {
+                return false;
+            }
+            pos += payloadSize;
+        }
+        return true;
+    }
+
+    bool WriteCompressed(const std::string& filePath, CompressedHeader header, const std::byte* records, size_t fieldCount, size_t blockRecords)
+    {
+        std::ofstream file(filePath, std::ios::binary | std::ios::trunc);
+        if (!file.is_open())
+        {
+            std::cerr << "Failed to open file: " << filePath << '\n';
+            return false;
+        }
+
+        blockRecords = std::max<size_t>(blockRecords, 1);
+        memcpy(header.magic, COMPRESSED_MAGIC, sizeof(header.magic));
+        header.version = StockData::COMPRESSED_VERSION;
+        header.blockRecords = blockRecords;
+        header.blockCount = (header.recordCount + blockRecords - 1) / blockRecords;
+        file.write((const char*)&header, sizeof(header));
+
+        const size_t recordSize = fieldCount * sizeof(uint64_t);
+        std::vector<CompressedBlockInfo> index(header.blockCount);
+        std::vector<uint8_t> block;
+        for (size_t b = 0; b < header.blockCount; ++b)
+        {
+            size_t first = b * blockRecords;
+            size_t count = std::min<size_t>(blockRecords, header.recordCount - first);
+            const std::byte* blockRecordsStart = records + first * recordSize;
+
+            block.clear();
+            EncodeBlock(blockRecordsStart, fieldCount, count, block);
+            index[b] = CompressedBlockInfo{
+                LoadBits(blockRecordsStart),
+                LoadBits(blockRecordsStart + (count - 1) * recordSize),
+                static_cast<uint64_t>(file.tellp()),
+                static_cast<uint32_t>(block.size()),
+                static_cast<uint32_t>(count)};
+            file.write((const char*)block.data(), block.size());
+        }
+
+        header.indexOffset = file.tellp();
+        file.write((const char*)index.data(), index.size() * sizeof(CompressedBlockInfo));
+        file.seekp(0);
+        file.write((const char*)&header, sizeof(header));
+        if (!file)
+        {
+            std::cerr << "Failed to write file: " << filePath << '\n';
+            return false;
+        }
+        return true;
+    }
+
+    /// @brief A compressed file opened for reading, with the blocks that overlap a time range
+    struct CompressedSource
+    {
+        std::ifstream file;
+        CompressedHeader header;
+        std::vector<CompressedBlockInfo> index;
+        size_t firstBlock = 0;
+        size_t endBlock = 0;
+        size_t recordCount = 0; // records in the selected blocks
+
+        bool Open(const std::string& filePath, CompressedKind kind, uint64_t fromTime, uint64_t toTime)
+        {
+            file.open(filePath, std::ios::binary);
+            if (!file.is_open())
+            {
+                std::cerr << "Failed to open file: " << filePath << '\n';
+                return false;
+            }
+
+            file.read((char*)&header, sizeof(header));
+            if (!file || memcmp(header.magic, COMPRESSED_MAGIC, sizeof(header.magic)) != 0
+                || header.version != StockData::COMPRESSED_VERSION || header.kind != kind)
+            {
+                std::cerr << "Invalid compressed file: " << filePath << '\n';
+                return false;
+            }
+
+            // the header and the index are checked against the file before anything is sized from them,
+            // so a truncated or corrupted file is reported instead of throwing from an allocation
+            file.seekg(0, std::ios::end);
+            const uint64_t fileSize = file.tellg();
+            if (!file || header.indexOffset < sizeof(header) || header.indexOffset > fileSize
+                || header.blockCount > (fileSize - header.indexOffset) / sizeof(CompressedBlockInfo))
+            {
+                std::cerr << "Invalid block index: " << filePath << '\n';
+                return false;
+            }
+
+            index.resize(header.blockCount);
+            file.seekg(header.indexOffset);
+            file.read((char*)index.data(), index.size() * sizeof(CompressedBlockInfo));
+            if (!file)
+            {
+                std::cerr << "Failed to read block index: " << filePath << '\n';
+                return false;
+            }
+
+            // every record takes at least one byte, its time varint, and blocks lie between the header and the index
+            uint64_t indexedRecords = 0;
+            for (const CompressedBlockInfo& block : index)
+            {
+                indexedRecords += block.recordCount;
+                if (block.recordCount == 0 || block.recordCount > block.size || block.offset < sizeof(header)
+                    || block.offset > header.indexOffset || block.size > header.indexOffset - block.offset
+                    || indexedRecords > header.recordCount)
+                {
+                    std::cerr << "Invalid block index: " << filePath << '\n';
+                    return false;
+                }
+            }
+            if (indexedRecords != header.recordCount)
+            {
+                std::cerr << "Invalid block index: " << filePath << '\n';
+                return false;
+            }
+
+            firstBlock = std::partition_point(index.begin(), index.end(),
+                [&](const CompressedBlockInfo& block) { return block.lastTime < fromTime; }) - index.begin();
+            endBlock = std::partition_point(index.begin() + firstBlock, index.end(),
+                [&](const CompressedBlockInfo& block) { return block.firstTime <= toTime; }) - index.begin();
+            recordCount = 0;
+            for (size_t b = firstBlock; b < endBlock; ++b)
+            {
+                recordCount += index[b].recordCount;
+            }
+            return true;
+        }
+
+        /// @brief Decode the selected blocks, record i going to each target's base + i * stride
+        bool Decode(const std::vector<FieldTarget>& targets, const std::string& filePath)
+        {
+            std::vector<uint8_t> block;
+            size_t first = 0;
+            for (size_t b = firstBlock; b < endBlock; ++b)
+            {
+                block.resize(index[b].size);
+                file.seekg(index[b].offset);
+                file.read((char*)block.data(), block.size());
+                if (!file || !DecodeBlock(block, index[b].recordCount, targets, first))
+                {
+                    std::cerr << "Corrupted block " << b << " in " << filePath << '\n';
+                    return false;
+                }
+                first += index[b].recordCount;
+            }
+            return true;
+        }
+    };
+
+    std::vector<FieldTarget> RecordTargets(std::byte* records, size_t fieldCount)
+    {
+        std::vector<FieldTarget> targets(fieldCount);
+        for (size_t field = 0; field < fieldCount; ++field)
+        {
+            targets[field] = FieldTarget{records + field * sizeof(uint64_t), fieldCount * sizeof(uint64_t)};
+        }
+        return targets;
+    }
+
+    /// @brief [first, end) of the records within the time range, only the ends of the decoded blocks can fall outside of it
+    template <typename TimeAt>
+    std::pair<size_t, size_t> TrimToTimeRange(size_t count, uint64_t fromTime, uint64_t toTime, TimeAt timeAt)
+    {
+        size_t first = 0;
+        while (first < count && timeAt(first) < fromTime)
+        {
+            ++first;
+        }
+        size_t end = count;
+        while (end > first && timeAt(end - 1) > toTime)
+        {
+            --end;
+        }
+        return {first, end};
+    }
+}
+
+bool StockData::WriteCompressedBars(const std::string &filePath, const Bars &bars, size_t blockRecords)
+{
+    CompressedHeader header{};
+    header.kind = CompressedKind::Bars;
+    memcpy(header.symbol, bars.symbol.data(), std::min(bars.symbol.size(), SYMBOL_SIZE));
+    header.frequency = static_cast<int32_t>(bars.frequency);
+    header.recordCount = bars.data.size();
+    return WriteCompressed(filePath, header, reinterpret_cast<const std::byte*>(bars.data.data()), BAR_FIELDS, blockRecords);
+}
+
+bool StockData::WriteCompressedTicks(const std::string &filePath, const Ticks &ticks, size_t blockRecords)
+{
+    CompressedHeader header{};
+    header.kind = CompressedKind::Ticks;
+    memcpy(header.symbol, ticks.symbol, SYMBOL_SIZE);
+    header.date = ticks.date;
+    header.recordCount = ticks.tickCount;
+    return WriteCompressed(filePath, header, reinterpret_cast<const std::byte*>(ticks.data), TICK_FIELDS, blockRecords);
+}
+
+bool StockData::ReadCompressedBars(const std::string &filePath, Bars &bars, uint64_t fromTime, uint64_t toTime)
+{
+    CompressedSource source;
+    if (!source.Open(filePath, CompressedKind::Bars, fromTime, toTime))
+    {
+        return false;
+    }
+
+    bars.symbol.assign(BARS_SYMBOL_SIZE + 1, '\0'); // +1 for null terminator, same as ReadBars
+    memcpy(bars.symbol.data(), source.header.symbol, BARS_SYMBOL_SIZE);
+    bars.frequency = static_cast<DataFrequency>(source.header.frequency);
+    bars.data = std::vector<Bar>(source.recordCount);
+    if (!source.Decode(RecordTargets(reinterpret_cast<std::byte*>(bars.data.data()), BAR_FIELDS), filePath))
+    {
+        bars.data.clear();
+        return false;
+    }
+
+    auto [first, end] = TrimToTimeRange(bars.data.size(), fromTime, toTime, [&](size_t i) { return bars.data[i].time; });
+    bars.data.erase(bars.data.begin() + end, bars.data.end());
+    bars.data.erase(bars.data.begin(), bars.data.begin() + first);
+    return true;
+}
+
+bool StockData::ReadCompressedTicks(const std::string &filePath, Ticks &ticks, uint64_t fromTime, uint64_t toTime)
+{
+    CompressedSource source;
+    if (!source.Open(filePath, CompressedKind::Ticks, fromTime, toTime))
+    {
+        return false;
+    }
+
+    memcpy(ticks.symbol, source.header.symbol, SYMBOL_SIZE);
+    ticks.date = source.header.date;
+    ticks.Allocate(source.recordCount);
+    ticks.tickCount = 0;
+    if (!source.Decode(RecordTargets(reinterpret_cast<std::byte*>(ticks.data), TICK_FIELDS), filePath))
+    {
+        return false;
+    }
+
+    auto [first, end] = TrimToTimeRange(source.recordCount, fromTime, toTime, [&](size_t i) { return ticks.data[i].time; });
+    memmove(ticks.data, ticks.data + first, (end - first) * sizeof(StockData::Tick));
+    ticks.tickCount = end - first;
+    return true;
+}
+
+bool StockData::ReadCompressedTicks(const std::string &filePath, TickColumns &ticks, uint64_t fromTime, uint64_t toTime)
+{
+    CompressedSource source;
+    if (!source.Open(filePath, CompressedKind::Ticks, fromTime, toTime))
+    {
+        return false;
+    }
+
+    memcpy(ticks.symbol, source.header.symbol, SYMBOL_SIZE);
+    ticks.date = source.header.date;
+    ticks.Resize(source.recordCount);
+
+    std::vector<FieldTarget> targets(TICK_FIELDS);
+    for (size_t field = 0; field < TICK_FIELDS; ++field)
+    {
+        targets[field] = FieldTarget{reinterpret_cast<std::byte*>(ticks.Column(static_cast<TickField>(field))), sizeof(uint64_t)};
+    }
+    if (!source.Decode(targets, filePath))
+    {
+        ticks.Resize(0);
+        return false;
+    }
+
+    auto [first, end] = TrimToTimeRange(source.recordCount, fromTime, toTime, [&](size_t i) { return ticks.Time()[i]; });
+    if (first > 0)
+    {
+        for (size_t field = 0; field < TICK_FIELDS; ++field)
+        {
+            double* column = ticks.Column(static_cast<TickField>(field));
+            memmove(column, column + first, (end - first) * sizeof(uint64_t));
+        }
+    }
+    ticks.Resize(end - first);
+    return true;
+}
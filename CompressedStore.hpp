@@ -0,0 +1,73 @@
+#pragma once
+#include <cstddef>
+#include <cstdint>
+#include <limits>
+#include <string>
+
+#include "StockData.hpp"
+#include "TickColumns.hpp"
+
+namespace StockData
+{
+    // Compressed bars (.1d.cbars / .1m.cbars) and ticks (.cticks).
+    // Records are grouped in blocks of a fixed number of records, each block stores one column per field:
+    // times as varint deltas, and every other field with the smallest lossless codec that fits the whole column:
+    // varint deltas of integers (volumes), varint deltas of integers in hundredths (prices in fen), or
+    // Gorilla-style XOR of consecutive doubles otherwise. A block index at the end of the file holds the
+    // time range of every block, so a time range only reads and decodes the blocks that overlap it.
+    constexpr uint32_t COMPRESSED_VERSION = 1;
+    constexpr size_t DEFAULT_BARS_PER_BLOCK = 4096;
+    constexpr size_t DEFAULT_TICKS_PER_BLOCK = 1024;
+
+    enum class CompressedKind : uint16_t
+    {
+        Bars = 0,
+        Ticks = 1
+    };
+
+    struct CompressedHeader
+    {
+        char magic[4];            // "SDCZ"
+        uint16_t version;
+        CompressedKind kind;
+        char symbol[SYMBOL_SIZE];
+        int32_t frequency;        // DataFrequency of bars
+        uint32_t blockRecords;    // records per block, the last block may hold fewer
+        uint64_t date;            // day of ticks
+        uint64_t recordCount;
+        uint64_t blockCount;
+        uint64_t indexOffset;     // offset of blockCount CompressedBlockInfo
+    };
+
+    struct CompressedBlockInfo
+    {
+        uint64_t firstTime;
+        uint64_t lastTime;
+        uint64_t offset;
+        uint32_t size;            // bytes
+        uint32_t recordCount;
+    };
+
+    /// @brief Write bars, sorted by time, to a compressed file
+    /// @return true if the file was written, false otherwise
+    bool WriteCompressedBars(const std::string& filePath, const Bars& bars, size_t blockRecords = DEFAULT_BARS_PER_BLOCK);
+
+    /// @brief Write a day of ticks, sorted by time, to a compressed file
+    /// @return true if the file was written, false otherwise
+    bool WriteCompressedTicks(const std::string& filePath, const Ticks& ticks, size_t blockRecords = DEFAULT_TICKS_PER_BLOCK);
+
+    /// @brief Read the bars of a compressed file with a time within [fromTime, toTime], counterpart of ReadBars
+    /// @return true if the file was read, false otherwise
+    bool ReadCompressedBars(const std::string& filePath, Bars& bars,
+        uint64_t fromTime = 0, uint64_t toTime = std::numeric_limits<uint64_t>::max());
+
+    /// @brief Read the ticks of a compressed file with a time within [fromTime, toTime], counterpart of ReadTicks.
+    /// ticks.data is allocated the same way ReadTicks does
+    /// @return true if the file was read, false otherwise
+    bool ReadCompressedTicks(const std::string& filePath, Ticks& ticks,
+        uint64_t fromTime = 0, uint64_t toTime = std::numeric_limits<uint64_t>::max());
+
+    /// @brief Read the ticks of a compressed file straight into columns, see ReadCompressedTicks
+    bool ReadCompressedTicks(const std::string& filePath, TickColumns& ticks,
+        uint64_t fromTime = 0, uint64_t toTime = std::numeric_limits<uint64_t>::max());
+}
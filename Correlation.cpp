@@ -0,0 +1,336 @@
+#include "Correlation.hpp"
+#include "Parallel.hpp"
+#include <algorithm>
+#include <cmath>
+#include <limits>
+
+namespace
+{
+    using StockData::Panel;
+    using StockData::PanelField;
+    using StockData::PairStatistic;
+    using StockData::ReturnSeries;
+    using StockData::ReturnType;
+
+    constexpr double MISSING = std::numeric_limits<double>::quiet_NaN();
+    constexpr size_t ROWS_PER_TASK = 64;     // rows of the sums updated by a task of a single date update
+    constexpr size_t TILE_ROWS = 16;         // a tile of the sums, 16 x 256 pairs of the four matrices is 128 KB and stays in L2
+    constexpr size_t TILE_COLUMNS = 256;     // across the dates of a pass
+    constexpr size_t DATES_PER_PASS = 128;
+    constexpr size_t DATES_PER_KERNEL = 4;   // dates applied per load and store of the sums, DATES_PER_PASS is a multiple of it
+    constexpr size_t BLOCK_SIZE = 64;        // GetMatrix reads the transposed sums in blocks
+    constexpr double VARIANCE_EPSILON = 1e-12; // relative to n·Σx², rounding left by removed dates is not a variance
+
+    /// @brief Fill rows [firstRow, DateCount()) of the returns from the closes of the panel
+    void FillReturns(const Panel& panel, size_t firstRow, ReturnSeries& returns)
+    {
+        const size_t symbolCount = panel.SymbolCount();
+        returns.values.resize(panel.DateCount() * symbolCount, MISSING);
+        for (size_t row = std::max<size_t>(firstRow, 1); row < panel.DateCount(); ++row)
+        {
+            const double* close = panel.Row(PanelField::Close, row);
+            const double* previousClose = panel.Row(PanelField::Close, row - 1);
+            const uint8_t* mask = panel.Mask(row);
+            const uint8_t* previousMask = panel.Mask(row - 1);
+            double* output = returns.values.data() + row * symbolCount;
+            for (size_t s = 0; s < symbolCount; ++s)
+            {
+                bool valid = mask[s] && previousMask[s] && close[s] > 0.0 && previousClose[s] > 0.0;
+                double ratio = valid ? close[s] / previousClose[s] : MISSING;
+                output[s] = returns.type == ReturnType::Log ? std::log(ratio) : ratio - 1.0;
+            }
+        }
+    }
+
+    /// @brief Split a row of returns into values with 0 where missing and a 0/1 mask, so the kernels never branch on NaN
+    void CleanRow(const double* returns, size_t count, double* values, double* mask)
+    {
+        for (size_t j = 0; j < count; ++j)
+        {
+            bool present = !std::isnan(returns[j]);
+            values[j] = present ? returns[j] : 0.0;
+            mask[j] = present ? 1.0 : 0.0;
+        }
+    }
+
+    // Adding a date where symbol i has return x to the sums of row i is a rank-1 update along j; only j's mask decides
+    // whether the pair shares the date, so removing a date is the same update with a sign of -1.
+    // The loop has no reduction, it vectorizes for 4 (AVX2) or 2 (SSE2) pairs at once without reassociating sums,
+    // and the sums come out the same whatever the tiling; target_clones picks the widest version the CPU supports
+
+    __attribute__((target_clones("avx2", "default")))
+    void AccumulateRow(double x, double sign, const double* values, const double* mask, size_t count,
+                       double* pairCount, double* sumX, double* sumXX, double* sumXY)
+    {
+        const double signedX = sign * x;
+        const double signedXX = sign * x * x;
+        for (size_t j = 0; j < count; ++j)
+        {
+            pairCount[j] += sign * mask[j];
+            sumX[j] += signedX * mask[j];
+            sumXX[j] += signedXX * mask[j];
+            sumXY[j] += signedX * values[j];
+        }
+    }
+
+    /// @brief Same as AccumulateRow for DATES_PER_KERNEL dates at once, with a present flag of i per date instead of a sign.
+    /// The dates are still added one after the other, so the sums are the same as adding them one by one
+    __attribute__((target_clones("avx2", "default")))
+    void AccumulateRowDates(const double* x, const double* present, const double* const* values, const double* const* mask, size_t count,
+                            double* pairCount, double* sumX, double* sumXX, double* sumXY)
+    {
+        const double x0 = x[0], x1 = x[1], x2 = x[2], x3 = x[3];
+        const double xx0 = x0 * x0, xx1 = x1 * x1, xx2 = x2 * x2, xx3 = x3 * x3;
+        const double p0 = present[0], p1 = present[1], p2 = present[2], p3 = present[3];
+        const double* v0 = values[0], * v1 = values[1], * v2 = values[2], * v3 = values[3];
+        const double* m0 = mask[0], * m1 = mask[1], * m2 = mask[2], * m3 = mask[3];
+        for (size_t j = 0; j < count; ++j)
+        {
+            double n = pairCount[j], sx = sumX[j], sxx = sumXX[j], sxy = sumXY[j];
+            n += p0 * m0[j]; sx += x0 * m0[j]; sxx += xx0 * m0[j]; sxy += x0 * v0[j];
+            n += p1 * m1[j]; sx += x1 * m1[j]; sxx += xx1 * m1[j]; sxy += x1 * v1[j];
+            n += p2 * m2[j]; sx += x2 * m2[j]; sxx += xx2 * m2[j]; sxy += x2 * v2[j];
+            n += p3 * m3[j]; sx += x3 * m3[j]; sxx += xx3 * m3[j]; sxy += x3 * v3[j];
+            pairCount[j] = n;
+            sumX[j] = sx;
+            sumXX[j] = sxx;
+            sumXY[j] = sxy;
+        }
+    }
+
+    double GetPairValue(PairStatistic statistic, double n, double sumX, double sumY, double sumXX, double sumYY, double sumXY, size_t minObservations)
+    {
+        if (n < static_cast<double>(std::max<size_t>(minObservations, 2)))
+        {
+            return MISSING;
+        }
+        double covariance = n * sumXY - sumX * sumY; // n² times the covariance with divisor n
+        if (statistic == PairStatistic::Covariance)
+        {
+            return covariance / (n * (n - 1.0));
+        }
+        double varianceX = n * sumXX - sumX * sumX;
+        double varianceY = n * sumYY - sumY * sumY;
+        if (varianceX <= VARIANCE_EPSILON * n * sumXX || varianceY <= VARIANCE_EPSILON * n * sumYY)
+        {
+            return MISSING;
+        }
+        return std::clamp(covariance / std::sqrt(varianceX * varianceY), -1.0, 1.0);
+    }
+}
+
+void StockData::ComputeReturns(const Panel &panel, ReturnType type, ReturnSeries &returns)
+{
+    returns.symbols = panel.symbols;
+    returns.dates = panel.dates;
+    returns.type = type;
+    returns.values.clear();
+    FillReturns(panel, 0, returns);
+}
+
+size_t StockData::ExtendReturns(const Panel &panel, ReturnSeries &returns)
+{
+    size_t firstRow = returns.DateCount();
+    if (returns.symbols != panel.symbols || firstRow > panel.DateCount()
+        || !std::equal(returns.dates.begin(), returns.dates.end(), panel.dates.begin()))
+    {
+        return 0;
+    }
+
+    returns.dates.assign(panel.dates.begin(), panel.dates.end());
+    FillReturns(panel, firstRow, returns);
+    return returns.DateCount() - firstRow;
+}
+
+void StockData::PairMoments::Reset(size_t symbols)
+{
+    symbolCount = symbols;
+    dateCount = 0;
+    for (std::vector<double>* sums : {&count, &sumX, &sumXX, &sumXY})
+    {
+        sums->assign(symbols * symbols, 0.0);
+    }
+}
+
+void StockData::PairMoments::AddDate(const double *returns, size_t threads)
+{
+    Update(returns, nullptr, threads);
+}
+
+void StockData::PairMoments::RemoveDate(const double *returns, size_t threads)
+{
+    Update(nullptr, returns, threads);
+}
+
+void StockData::PairMoments::RollDate(const double *added, const double *removed, size_t threads)
+{
+    Update(added, removed, threads);
+}
+
+void StockData::PairMoments::Update(const double *added, const double *removed, size_t threads)
+{
+    const size_t n = symbolCount;
+    std::vector<double> addedValues(n), addedMask(n), removedValues(n), removedMask(n);
+    if (added != nullptr)
+    {
+        CleanRow(added, n, addedValues.data(), addedMask.data());
+        ++dateCount;
+    }
+    if (removed != nullptr)
+    {
+        CleanRow(removed, n, removedValues.data(), removedMask.data());
+        dateCount -= std::min<size_t>(dateCount, 1);
+    }
+
+    // both dates are applied to a row while it is in cache, so a rolling step reads the sums once
+    size_t taskCount = (n + ROWS_PER_TASK - 1) / ROWS_PER_TASK;
+    ParallelFor(taskCount, threads, [&](size_t task)
+    {
+        size_t endRow = std::min(n, (task + 1) * ROWS_PER_TASK);
+        for (size_t i = task * ROWS_PER_TASK; i < endRow; ++i)
+        {
+            size_t offset = i * n;
+            if (addedMask[i] != 0.0)
+            {
+                AccumulateRow(addedValues[i], 1.0, addedValues.data(), addedMask.data(), n,
+                              &count[offset], &sumX[offset], &sumXX[offset], &sumXY[offset]);
+            }
+            if (removedMask[i] != 0.0)
+            {
+                AccumulateRow(removedValues[i], -1.0, removedValues.data(), removedMask.data(), n,
+                              &count[offset], &sumX[offset], &sumXX[offset], &sumXY[offset]);
+            }
+        }
+    });
+}
+
+void StockData::PairMoments::AddDates(const double *returns, size_t dates, size_t threads)
+{
+    const size_t n = symbolCount;
+    const size_t rowTiles = (n + TILE_ROWS - 1) / TILE_ROWS;
+    const size_t columnTiles = (n + TILE_COLUMNS - 1) / TILE_COLUMNS;
+    // rows past the last date stay 0 and add nothing, so a pass is always a whole number of kernel dates
+    size_t bufferDates = (std::min(dates, DATES_PER_PASS) + DATES_PER_KERNEL - 1) / DATES_PER_KERNEL * DATES_PER_KERNEL;
+    std::vector<double> values(bufferDates * n), mask(values.size());
+
+    // each task owns a tile of the sums and runs every date of the pass through it before moving on,
+    // so the sums are read from memory once per pass instead of once per date
+    for (size_t firstDate = 0; firstDate < dates; firstDate += DATES_PER_PASS)
+    {
+        size_t passDates = std::min(DATES_PER_PASS, dates - firstDate);
+        for (size_t t = 0; t < passDates; ++t)
+        {
+            CleanRow(returns + (firstDate + t) * n, n, &values[t * n], &mask[t * n]);
+        }
+        std::fill(values.begin() + passDates * n, values.end(), 0.0);
+        std::fill(mask.begin() + passDates * n, mask.end(), 0.0);
+
+        ParallelFor(rowTiles * columnTiles, threads, [&](size_t tile)
+        {
+            size_t firstRow = (tile / columnTiles) * TILE_ROWS;
+            size_t endRow = std::min(n, firstRow + TILE_ROWS);
+            size_t firstColumn = (tile % columnTiles) * TILE_COLUMNS;
+            size_t columns = std::min(n, firstColumn + TILE_COLUMNS) - firstColumn;
+            for (size_t t = 0; t < passDates; t += DATES_PER_KERNEL)
+            {
+                const double* rowValues[DATES_PER_KERNEL];
+                const double* rowMask[DATES_PER_KERNEL];
+                for (size_t k = 0; k < DATES_PER_KERNEL; ++k)
+                {
+                    rowValues[k] = &values[(t + k) * n];
+                    rowMask[k] = &mask[(t + k) * n];
+                }
+                const double* columnValues[DATES_PER_KERNEL];
+                const double* columnMask[DATES_PER_KERNEL];
+                for (size_t k = 0; k < DATES_PER_KERNEL; ++k)
+                {
+                    columnValues[k] = rowValues[k] + firstColumn;
+                    columnMask[k] = rowMask[k] + firstColumn;
+                }
+
+                for (size_t i = firstRow; i < endRow; ++i)
+                {
+                    double x[DATES_PER_KERNEL];
+                    double present[DATES_PER_KERNEL];
+                    double any = 0.0;
+                    for (size_t k = 0; k < DATES_PER_KERNEL; ++k)
+                    {
+                        x[k] = rowValues[k][i];
+                        present[k] = rowMask[k][i];
+                        any += present[k];
+                    }
+                    if (any != 0.0)
+                    {
+                        size_t offset = i * n + firstColumn;
+                        AccumulateRowDates(x, present, columnValues, columnMask, columns,
+                                           &count[offset], &sumX[offset], &sumXX[offset], &sumXY[offset]);
+                    }
+                }
+            }
+        });
+    }
+    dateCount += dates;
+}
+
+double StockData::PairMoments::Get(PairStatistic statistic, size_t i, size_t j, size_t minObservations) const
+{
+    size_t ij = i * symbolCount + j;
+    size_t ji = j * symbolCount + i;
+    double value = GetPairValue(statistic, count[ij], sumX[ij], sumX[ji], sumXX[ij], sumXX[ji], sumXY[ij], minObservations);
+    return i == j && statistic == PairStatistic::Correlation && !std::isnan(value) ? 1.0 : value; // exact, not up to rounding
+}
+
+void StockData::PairMoments::GetMatrix(PairStatistic statistic, size_t minObservations, size_t threads, std::vector<double> &matrix) const
+{
+    const size_t n = symbolCount;
+    matrix.resize(n * n);
+    size_t blocks = (n + BLOCK_SIZE - 1) / BLOCK_SIZE;
+    ParallelFor(blocks, threads, [&](size_t rowBlock)
+    {
+        size_t firstRow = rowBlock * BLOCK_SIZE;
+        size_t endRow = std::min(n, firstRow + BLOCK_SIZE);
+        for (size_t firstColumn = 0; firstColumn < n; firstColumn += BLOCK_SIZE)
+        {
+            size_t endColumn = std::min(n, firstColumn + BLOCK_SIZE);
+            for (size_t i = firstRow; i < endRow; ++i)
+            {
+                for (size_t j = firstColumn; j < endColumn; ++j)
+                {
+                    matrix[i * n + j] = Get(statistic, i, j, minObservations);
+                }
+            }
+        }
+    });
+}
+
+void StockData::ComputePairMatrix(const ReturnSeries &returns, size_t firstDateIndex, size_t dateCount, PairStatistic statistic,
+                                  size_t minObservations, size_t threads, std::vector<double> &matrix)
+{
+    firstDateIndex = std::min(firstDateIndex, returns.DateCount());
+    dateCount = std::min(dateCount, returns.DateCount() - firstDateIndex);
+
+    PairMoments moments;
+    moments.Reset(returns.SymbolCount());
+    moments.AddDates(returns.Row(firstDateIndex), dateCount, threads);
+    moments.GetMatrix(statistic, minObservations, threads, matrix);
+}
+
+void StockData::ForEachRollingWindow(const ReturnSeries &returns, size_t window, size_t threads,
+                                     const std::function<void(size_t dateIndex, const PairMoments &moments)> &function)
+{
+    window = std::max<size_t>(window, 1);
+    if (returns.DateCount() < window)
+    {
+        return;
+    }
+
+    PairMoments moments;
+    moments.Reset(returns.SymbolCount());
+    moments.AddDates(returns.Row(0), window, threads);
+    function(window - 1, moments);
+    for (size_t t = window; t < returns.DateCount(); ++t)
+    {
+        moments.RollDate(returns.Row(t), returns.Row(t - window), threads);
+        function(t, moments);
+    }
+}
@@ -0,0 +1,230 @@
+#include "Indicators.hpp"
+#include <algorithm>
+#include <cmath>
+
+void StockData::CompensatedSum::Add(double value)
+{
+    double total = sum + value;
+    if (std::fabs(sum) >= std::fabs(value))
+    {
+        compensation += (sum - total) + value;
+    }
+    else
+    {
+        compensation += (value - total) + sum;
+    }
+    sum = total;
+}
+
+StockData::RollingWindow::RollingWindow(size_t window)
+    : values(std::max<size_t>(window, 1))
+{}
+
+bool StockData::RollingWindow::Push(double value, double &evicted)
+{
+    bool full = Full();
+    if (full)
+    {
+        evicted = values[next];
+    }
+    else
+    {
+        ++count;
+    }
+    values[next] = value;
+    next = next + 1 == values.size() ? 0 : next + 1;
+    return full;
+}
+
+StockData::Sma::Sma(size_t window)
+    : values(window)
+{}
+
+double StockData::Sma::Push(double value)
+{
+    double evicted;
+    if (values.Push(value, evicted))
+    {
+        sum.Add(-evicted);
+    }
+    sum.Add(value);
+    return Value();
+}
+
+double StockData::Sma::Value() const
+{
+    return Ready() ? sum.Value() / values.Capacity() : INDICATOR_NOT_READY;
+}
+
+void StockData::Sma::Reset()
+{
+    values.Reset();
+    sum.Reset();
+}
+
+StockData::Ema::Ema(size_t period)
+    : alpha(2.0 / (period + 1.0))
+{}
+
+double StockData::Ema::Push(double newValue)
+{
+    value = count == 0 ? newValue : value + alpha * (newValue - value);
+    ++count;
+    return value;
+}
+
+StockData::Vwap::Vwap(size_t window)
+    : window(window), amounts(window), volumes(window)
+{}
+
+double StockData::Vwap::Push(double newAmount, double newVolume)
+{
+    if (window > 0)
+    {
+        double evicted;
+        if (amounts.Push(newAmount, evicted))
+        {
+            amount.Add(-evicted);
+        }
+        if (volumes.Push(newVolume, evicted))
+        {
+            volume.Add(-evicted);
+        }
+    }
+    amount.Add(newAmount);
+    volume.Add(newVolume);
+    ++count;
+    return Value();
+}
+
+bool StockData::Vwap::Ready() const
+{
+    return window > 0 ? count >= window : count > 0;
+}
+
+double StockData::Vwap::Value() const
+{
+    double totalVolume = volume.Value();
+    return Ready() && totalVolume > 0.0 ? amount.Value() / totalVolume : INDICATOR_NOT_READY;
+}
+
+void StockData::Vwap::Reset()
+{
+    amounts.Reset();
+    volumes.Reset();
+    amount.Reset();
+    volume.Reset();
+    count = 0;
+}
+
+StockData::Atr::Atr(size_t period)
+    : period(std::max<size_t>(period, 1))
+{}
+
+double StockData::Atr::Push(double high, double low, double close)
+{
+    double trueRange = high - low;
+    if (count > 0)
+    {
+        trueRange = std::max({trueRange, std::fabs(high - previousClose), std::fabs(low - previousClose)});
+    }
+    previousClose = close;
+    ++count;
+
+    if (count <= period)
+    {
+        value += (trueRange - value) / count; // running mean of the first true ranges
+    }
+    else
+    {
+        value += (trueRange - value) / period;
+    }
+    return Value();
+}
+
+template <typename Dominates>
+void StockData::RollingMinMax::MonotonicQueue::Push(uint64_t position, double value, uint64_t window, Dominates dominates)
+{
+    // drop the values that can no longer be the extreme of any window
+    while (size > 0 && !dominates(values[At(size - 1)], value))
+    {
+        --size;
+    }
+    while (size > 0 && positions[head] + window <= position)
+    {
+        head = At(1);
+        --size;
+    }
+    size_t back = At(size);
+    positions[back] = position;
+    values[back] = value;
+    ++size;
+}
+
+StockData::RollingMinMax::RollingMinMax(size_t window)
+    : window(std::max<size_t>(window, 1)), minimums(this->window), maximums(this->window)
+{}
+
+void StockData::RollingMinMax::Push(double value)
+{
+    minimums.Push(count, value, window, [](double kept, double added) { return kept < added; });
+    maximums.Push(count, value, window, [](double kept, double added) { return kept > added; });
+    ++count;
+}
+
+double StockData::RollingMinMax::Min() const
+{
+    return Ready() ? minimums.values[minimums.head] : INDICATOR_NOT_READY;
+}
+
+double StockData::RollingMinMax::Max() const
+{
+    return Ready() ? maximums.values[maximums.head] : INDICATOR_NOT_READY;
+}
+
+void StockData::RollingMinMax::Reset()
+{
+    count = 0;
+    minimums.head = minimums.size = 0;
+    maximums.head = maximums.size = 0;
+}
+
+StockData::RollingStdev::RollingStdev(size_t window)
+    : values(window)
+{}
+
+double StockData::RollingStdev::Push(double value)
+{
+    double evicted;
+    if (values.Push(value, evicted))
+    {
+        // replace evicted by value, the count stays the same
+        double previousMean = mean;
+        mean += (value - evicted) / values.Size();
+        m2 += (value - evicted) * (value - mean + evicted - previousMean);
+        m2 = std::max(m2, 0.0);
+    }
+    else
+    {
+        double delta = value - mean;
+        mean += delta / values.Size();
+        m2 += delta * (value - mean);
+    }
+    return Value();
+}
+
+double StockData::RollingStdev::Value() const
+{
+    if (!Ready())
+    {
+        return INDICATOR_NOT_READY;
+    }
+    return values.Size() > 1 ? std::sqrt(m2 / (values.Size() - 1)) : 0.0;
+}
+
+void StockData::RollingStdev::Reset()
+{
+    values.Reset();
+    mean = 0.0;
+    m2 = 0.0;
+}
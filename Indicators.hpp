@@ -0,0 +1,271 @@
+#pragma once
+#include <cstddef>
+#include <cstdint>
+#include <limits>
+#include <vector>
+
+#include "StockData.hpp"
+
+namespace StockData
+{
+    enum class BarField
+    {
+        Open = 0,
+        High,
+        Low,
+        Close,
+        Volume,
+        Amount
+    };
+
+    inline double GetBarField(const Bar& bar, BarField field)
+    {
+        switch (field)
+        {
+            case BarField::Open: return bar.open;
+            case BarField::High: return bar.high;
+            case BarField::Low: return bar.low;
+            case BarField::Close: return bar.close;
+            case BarField::Volume: return bar.volume;
+            case BarField::Amount: return bar.amount;
+        }
+        return 0.0;
+    }
+
+    inline double GetBarField(const AugmentedBar& bar, BarField field)
+    {
+        switch (field)
+        {
+            case BarField::Open: return bar.open;
+            case BarField::High: return bar.high;
+            case BarField::Low: return bar.low;
+            case BarField::Close: return bar.close;
+            case BarField::Volume: return bar.volume;
+            case BarField::Amount: return bar.amount;
+        }
+        return 0.0;
+    }
+
+    // Indicators are pushed one value (or bar) at a time and update in O(1), with no allocation after construction.
+    // Push returns the current value, NaN until the indicator has seen enough values (see Ready)
+    constexpr double INDICATOR_NOT_READY = std::numeric_limits<double>::quiet_NaN();
+
+    /// @brief Running sum with Neumaier compensation, so adding and removing values over a long series does not drift
+    struct CompensatedSum
+    {
+        void Add(double value);
+        double Value() const { return sum + compensation; }
+        void Reset() { sum = 0.0; compensation = 0.0; }
+
+    private:
+        double sum = 0.0;
+        double compensation = 0.0;
+    };
+
+    /// @brief Fixed size ring of the last values pushed
+    struct RollingWindow
+    {
+        explicit RollingWindow(size_t window);
+
+        /// @brief Add a value, evicting the oldest one once full
+        /// @param evicted the value that left the window, if any
+        /// @return true if a value was evicted
+        bool Push(double value, double& evicted);
+
+        size_t Capacity() const { return values.size(); }
+        size_t Size() const { return count; }
+        bool Full() const { return count == values.size(); }
+        void Reset() { next = 0; count = 0; }
+
+    private:
+        std::vector<double> values;
+        size_t next = 0;
+        size_t count = 0;
+    };
+
+    /// @brief Simple moving average
+    struct Sma
+    {
+        explicit Sma(size_t window);
+        double Push(double value);
+        bool Ready() const { return values.Full(); }
+        double Value() const;
+        void Reset();
+
+    private:
+        RollingWindow values;
+        CompensatedSum sum;
+    };
+
+    /// @brief Exponential moving average with alpha = 2 / (period + 1), seeded with the first value
+    struct Ema
+    {
+        explicit Ema(size_t period);
+        double Push(double value);
+        bool Ready() const { return count > 0; }
+        double Value() const { return Ready() ? value : INDICATOR_NOT_READY; }
+        void Reset() { value = 0.0; count = 0; }
+
+    private:
+        double alpha;
+        double value = 0.0;
+        size_t count = 0;
+    };
+
+    /// @brief Volume weighted average price, sum(amount) / sum(volume), which is AugmentedBar::average over more than one bar
+    struct Vwap
+    {
+        /// @param window number of bars, 0 to accumulate every bar since the last Reset (e.g. one per day for 1m bars)
+        explicit Vwap(size_t window = 0);
+        double Push(double amount, double volume);
+        bool Ready() const;
+        double Value() const;
+        void Reset();
+
+    private:
+        size_t window;
+        RollingWindow amounts;
+        RollingWindow volumes;
+        CompensatedSum amount;
+        CompensatedSum volume;
+        size_t count = 0;
+    };
+
+    /// @brief Average true range with Wilder smoothing, the first value is the mean of the first `period` true ranges
+    struct Atr
+    {
+        explicit Atr(size_t period);
+        double Push(double high, double low, double close);
+        bool Ready() const { return count >= period; }
+        double Value() const { return Ready() ? value : INDICATOR_NOT_READY; }
+        void Reset() { value = 0.0; previousClose = 0.0; count = 0; }
+
+    private:
+        size_t period;
+        double value = 0.0;
+        double previousClose = 0.0;
+        size_t count = 0;
+    };
+
+    /// @brief Minimum and maximum over the last `window` values, amortized O(1) with monotonic queues
+    struct RollingMinMax
+    {
+        explicit RollingMinMax(size_t window);
+        void Push(double value);
+        bool Ready() const { return count >= window; }
+        double Min() const;
+        double Max() const;
+        void Reset();
+
+    private:
+        /// @brief Fixed capacity deque of (position, value), values are kept monotonic
+        struct MonotonicQueue
+        {
+            explicit MonotonicQueue(size_t capacity) : positions(capacity), values(capacity) {}
+            std::vector<uint64_t> positions;
+            std::vector<double> values;
+            size_t head = 0;
+            size_t size = 0;
+
+            size_t At(size_t i) const { return (head + i) % positions.size(); }
+            template <typename Dominates>
+            void Push(uint64_t position, double value, uint64_t window, Dominates dominates);
+        };
+
+        size_t window;
+        uint64_t count = 0;
+        MonotonicQueue minimums;
+        MonotonicQueue maximums;
+    };
+
+    /// @brief Sample standard deviation over the last `window` values, updated with Welford's method
+    struct RollingStdev
+    {
+        explicit RollingStdev(size_t window);
+        double Push(double value);
+        bool Ready() const { return values.Full(); }
+        double Mean() const { return Ready() ? mean : INDICATOR_NOT_READY; }
+        double Value() const;
+        void Reset();
+
+    private:
+        RollingWindow values;
+        double mean = 0.0;
+        double m2 = 0.0;  // sum of squared deviations from the mean
+    };
+
+    // Batch versions run the same accumulators over a whole series, so they match the streaming results exactly.
+    // output has one value per bar (count of them) and must be preallocated, bars before the indicator is ready get NaN.
+    // T is any bar type with a GetBarField overload: Bar, AugmentedBar, or CompactBar (see CompactRecords.hpp)
+
+    template <typename T>
+    void ComputeSma(const T* bars, size_t count, BarField field, size_t window, double* output)
+    {
+        Sma sma(window);
+        for (size_t i = 0; i < count; ++i)
+        {
+            output[i] = sma.Push(GetBarField(bars[i], field));
+        }
+    }
+
+    template <typename T>
+    void ComputeEma(const T* bars, size_t count, BarField field, size_t period, double* output)
+    {
+        Ema ema(period);
+        for (size_t i = 0; i < count; ++i)
+        {
+            output[i] = ema.Push(GetBarField(bars[i], field));
+        }
+    }
+
+    /// @param window see Vwap
+    template <typename T>
+    void ComputeVwap(const T* bars, size_t count, size_t window, double* output)
+    {
+        Vwap vwap(window);
+        for (size_t i = 0; i < count; ++i)
+        {
+            output[i] = vwap.Push(GetBarField(bars[i], BarField::Amount), GetBarField(bars[i], BarField::Volume));
+        }
+    }
+
+    template <typename T>
+    void ComputeAtr(const T* bars, size_t count, size_t period, double* output)
+    {
+        Atr atr(period);
+        for (size_t i = 0; i < count; ++i)
+        {
+            output[i] = atr.Push(GetBarField(bars[i], BarField::High), GetBarField(bars[i], BarField::Low), GetBarField(bars[i], BarField::Close));
+        }
+    }
+
+    /// @param minimums may be nullptr
+    /// @param maximums may be nullptr
+    template <typename T>
+    void ComputeRollingMinMax(const T* bars, size_t count, BarField field, size_t window, double* minimums, double* maximums)
+    {
+        RollingMinMax minMax(window);
+        for (size_t i = 0; i < count; ++i)
+        {
+            minMax.Push(GetBarField(bars[i], field));
+            if (minimums != nullptr)
+            {
+                minimums[i] = minMax.Min();
+            }
+            if (maximums != nullptr)
+            {
+                maximums[i] = minMax.Max();
+            }
+        }
+    }
+
+    template <typename T>
+    void ComputeRollingStdev(const T* bars, size_t count, BarField field, size_t window, double* output)
+    {
+        RollingStdev stdev(window);
+        for (size_t i = 0; i < count; ++i)
+        {
+            output[i] = stdev.Push(GetBarField(bars[i], field));
+        }
+    }
+}
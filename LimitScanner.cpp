@@ -0,0 +1,164 @@
+#include "LimitScanner.hpp"
+#include "Aggregation.hpp"
+#include "Parallel.hpp"
+#include "TickStream.hpp"
+#include <algorithm>
+#include <cmath>
+#include <cstring>
+#include <tuple>
+
+namespace
+{
+    using StockData::Bar;
+    using StockData::Bars;
+    using StockData::Event;
+    using StockData::EventTypes;
+
+    constexpr double PRICE_TOLERANCE = 0.005; // half a cent, prices are quoted in cents
+    constexpr uint64_t CHINEXT_REFORM_DATE = 20200824;
+
+    bool StartsWith(const std::string& symbol, const char* prefix)
+    {
+        return symbol.compare(0, strlen(prefix), prefix) == 0;
+    }
+
+    bool ReachedLimit(EventTypes eventType, double price, double limitPrice)
+    {
+        return eventType == EventTypes::LimitUp ? price >= limitPrice - PRICE_TOLERANCE : price <= limitPrice + PRICE_TOLERANCE;
+    }
+
+    uint32_t FindMinuteBarTime(const std::string& symbol, const Event& event, double limitPrice)
+    {
+        Bars minutes;
+        std::string error;
+        if (!StockData::ReadBars(StockData::GetFilePath(symbol, StockData::DataFrequency::Bar1m, event.Date), minutes, error))
+        {
+            return 0;
+        }
+        for (const Bar& bar : minutes.data)
+        {
+            double extreme = event.EventType == EventTypes::LimitUp ? bar.high : bar.low;
+            if (ReachedLimit(event.EventType, extreme, limitPrice))
+            {
+                return StockData::GetBarTimeOfDay(bar.time);
+            }
+        }
+        return 0;
+    }
+
+    uint32_t FindTickTime(const std::string& symbol, const Event& event, double limitPrice)
+    {
+        StockData::TickStream stream;
+        if (!stream.Open(StockData::GetFilePath(symbol, StockData::DataFrequency::Tick, event.Date)))
+        {
+            return 0;
+        }
+        for (auto batch = stream.NextBatch(); !batch.empty(); batch = stream.NextBatch())
+        {
+            for (const StockData::Tick& tick : batch)
+            {
+                if (tick.price > 0.0 && ReachedLimit(event.EventType, tick.price, limitPrice))
+                {
+                    return tick.time;
+                }
+            }
+        }
+        return 0;
+    }
+}
+
+double StockData::GetLimitRatio(const std::string &symbol, uint64_t date, bool specialTreatment)
+{
+    if (StartsWith(symbol, "688"))
+    {
+        return 0.2;
+    }
+    if (StartsWith(symbol, "300") || StartsWith(symbol, "301"))
+    {
+        if (date >= CHINEXT_REFORM_DATE)
+        {
+            return 0.2;
+        }
+        return specialTreatment ? 0.05 : 0.1;
+    }
+    if (StartsWith(symbol, "4") || StartsWith(symbol, "8") || StartsWith(symbol, "92"))
+    {
+        return 0.3;
+    }
+    return specialTreatment ? 0.05 : 0.1;
+}
+
+void StockData::GetLimitPrices(double previousClose, double ratio, double &limitUp, double &limitDown)
+{
+    // the epsilon keeps products such as 9.05 * 1.1 = 9.955 from rounding down
+    limitUp = std::floor(previousClose * (1.0 + ratio) * 100.0 + 0.5 + 1e-6) / 100.0;
+    limitDown = std::floor(previousClose * (1.0 - ratio) * 100.0 + 0.5 + 1e-6) / 100.0;
+}
+
+void StockData::ScanLimitEvents(const std::string &symbol, const Bars &bars, const LimitRules &rules, std::vector<Event> &events)
+{
+    const bool specialTreatment = rules.specialTreatment.count(symbol) > 0;
+    const std::vector<Bar>& data = bars.data;
+    for (size_t i = 1; i < data.size(); ++i)
+    {
+        const Bar& bar = data[i];
+        if (bar.volume <= 0.0 || data[i - 1].close <= 0.0)
+        {
+            continue;
+        }
+
+        double limitUp, limitDown;
+        GetLimitPrices(data[i - 1].close, GetLimitRatio(symbol, bar.time, specialTreatment), limitUp, limitDown);
+
+        double upPrice = rules.onTouch ? bar.high : bar.close;
+        double downPrice = rules.onTouch ? bar.low : bar.close;
+        for (auto [eventType, price, limitPrice] : {std::tuple(EventTypes::LimitUp, upPrice, limitUp), std::tuple(EventTypes::LimitDown, downPrice, limitDown)})
+        {
+            if (!ReachedLimit(eventType, price, limitPrice))
+            {
+                continue;
+            }
+            Event event(symbol, eventType, static_cast<uint32_t>(bar.time));
+            switch (rules.timeSource)
+            {
+                case LimitTimeSource::MinuteBars:
+                    event.Time = FindMinuteBarTime(symbol, event, limitPrice);
+                    break;
+                case LimitTimeSource::Ticks:
+                    event.Time = FindTickTime(symbol, event, limitPrice);
+                    break;
+                default:
+                    break;
+            }
+            events.push_back(std::move(event));
+        }
+    }
+}
+
+void StockData::ScanLimitEvents(const Universe &universe, const LimitRules &rules, size_t threads, std::vector<Event> &events)
+{
+    events.clear();
+
+    std::vector<std::vector<Event>> symbolEvents(universe.symbols.size());
+    ParallelFor(universe.symbols.size(), threads, [&](size_t i)
+    {
+        ScanLimitEvents(universe.symbols[i], universe.bars[i], rules, symbolEvents[i]);
+    });
+
+    size_t eventCount = 0;
+    for (const auto& symbolEvent : symbolEvents)
+    {
+        eventCount += symbolEvent.size();
+    }
+    events.reserve(eventCount);
+    for (auto& symbolEvent : symbolEvents)
+    {
+        std::move(symbolEvent.begin(), symbolEvent.end(), std::back_inserter(events));
+    }
+
+    // symbols are already in universe order, so a stable sort keeps that order within a date and time
+    std::stable_sort(events.begin(), events.end(), [](const Event& a, const Event& b)
+    {
+        return a.Date != b.Date ? a.Date < b.Date : a.Time < b.Time;
+    });
+}
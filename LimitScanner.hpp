@@ -0,0 +1,49 @@
+#pragma once
+#include <cstddef>
+#include <cstdint>
+#include <string>
+#include <unordered_set>
+#include <vector>
+
+#include "StockData.hpp"
+#include "Universe.hpp"
+
+namespace StockData
+{
+    /// @brief Where ScanLimitEvents looks up the time of day an event happened
+    enum class LimitTimeSource
+    {
+        None = 0,   // Event::Time stays 0
+        MinuteBars, // end of the first 1m bar that reached the limit
+        Ticks       // first tick at the limit
+    };
+
+    struct LimitRules
+    {
+        std::unordered_set<std::string> specialTreatment; // ST / *ST symbols, 5% limit on the main boards
+        bool onTouch = false;                             // high/low reaching the limit instead of closing at it
+        LimitTimeSource timeSource = LimitTimeSource::None;
+    };
+
+    /// @brief Daily price limit of a symbol, as a ratio of the previous close:
+    /// 20% on STAR (688) and on ChiNext (300, 301) from 20200824, 30% on the Beijing exchange (4, 8, 92),
+    /// 5% for ST symbols on the main boards, 10% otherwise
+    double GetLimitRatio(const std::string& symbol, uint64_t date, bool specialTreatment);
+
+    /// @brief Limit prices from the previous close, rounded half up to the cent like the exchanges do
+    void GetLimitPrices(double previousClose, double ratio, double& limitUp, double& limitDown);
+
+    /// @brief Find the limit events of one symbol. The first bar has no previous close and is skipped,
+    /// as are bars without volume (suspended days)
+    /// @param bars daily bars, sorted by date
+    /// @param events the events are appended in date order
+    void ScanLimitEvents(const std::string& symbol, const Bars& bars, const LimitRules& rules, std::vector<Event>& events);
+
+    /// @brief Find the limit events of a daily universe on a pool of worker threads.
+    /// When the rules ask for a time source, Event::Time is the HHMMSS the limit was first reached,
+    /// or stays 0 if the intraday file of that day is missing
+    /// @param universe daily bars, see LoadUniverse
+    /// @param threads number of worker threads, 0 for one per hardware thread
+    /// @param events the results sorted by date and time, then in universe order, gets cleared in this function
+    void ScanLimitEvents(const Universe& universe, const LimitRules& rules, size_t threads, std::vector<Event>& events);
+}
@@ -0,0 +1,472 @@
+#include "LiveIngest.hpp"
+#include "Aggregation.hpp"
+#include "TickStream.hpp"
+#include <algorithm>
+#include <cerrno>
+#include <chrono>
+#include <cstring>
+#include <fcntl.h>
+#include <poll.h>
+#include <sys/socket.h>
+#include <sys/stat.h>
+#include <sys/un.h>
+#include <unistd.h>
+
+#if defined(__x86_64__) || defined(__i386__)
+#include <immintrin.h>
+#endif
+
+namespace
+{
+    using StockData::LiveTick;
+
+    constexpr size_t READ_BATCH_TICKS = 64;
+    constexpr int POLL_TIMEOUT_MS = 50;      // how often a reader blocked on a quiet feed checks for Stop
+    constexpr size_t CONSUMER_BURST = 256;   // ticks taken from one ring before moving on to the next
+    constexpr size_t IDLE_SPINS = 1024;      // empty polls before a waiting thread starts sleeping
+    constexpr std::chrono::microseconds MIN_IDLE_SLEEP{10};
+    constexpr std::chrono::microseconds MAX_IDLE_SLEEP{1000}; // bounds the latency of the first tick after a quiet spell, and of Stop
+
+    /// @brief Tell the CPU the thread is spinning, which frees resources for the other hyperthread and saves power
+    inline void CpuRelax()
+    {
+#if defined(__x86_64__) || defined(__i386__)
+        _mm_pause();
+#elif defined(__aarch64__)
+        asm volatile("yield");
+#else
+        std::this_thread::yield();
+#endif
+    }
+
+    /// @brief Spin while the wait is likely short, then sleep twice as long each time, up to MAX_IDLE_SLEEP
+    struct IdleBackoff
+    {
+        bool sleeps = true; // false to spin for as long as the wait lasts
+        size_t spins = 0;
+        std::chrono::microseconds sleep{0};
+
+        void Reset()
+        {
+            spins = 0;
+            sleep = std::chrono::microseconds{0};
+        }
+
+        void Wait()
+        {
+            if (!sleeps || ++spins <= IDLE_SPINS)
+            {
+                CpuRelax();
+                return;
+            }
+            sleep = std::clamp(sleep * 2, MIN_IDLE_SLEEP, MAX_IDLE_SLEEP);
+            std::this_thread::sleep_for(sleep);
+        }
+    };
+
+    bool WriteAll(int fd, const void* data, size_t size)
+    {
+        const char* bytes = static_cast<const char*>(data);
+        while (size > 0)
+        {
+            ssize_t written = write(fd, bytes, size);
+            if (written < 0)
+            {
+                if (errno == EINTR)
+                {
+                    continue;
+                }
+                return false;
+            }
+            bytes += written;
+            size -= written;
+        }
+        return true;
+    }
+}
+
+StockData::LiveBarBuilder::LiveBarBuilder(const std::vector<std::string> &followedSymbols)
+    : symbols(followedSymbols), states(std::make_unique<SymbolState[]>(followedSymbols.size()))
+{
+    for (size_t i = 0; i < symbols.size(); ++i)
+    {
+        symbolIndices.emplace(symbols[i], i);
+    }
+}
+
+bool StockData::LiveBarBuilder::FindSymbol(const std::string &symbol, size_t &symbolIndex) const
+{
+    auto it = symbolIndices.find(symbol);
+    if (it == symbolIndices.end())
+    {
+        return false;
+    }
+    symbolIndex = it->second;
+    return true;
+}
+
+void StockData::LiveBarBuilder::CloseMinutes(size_t symbolIndex, SymbolState &state, size_t untilIndex)
+{
+    if (!state.minuteOpen)
+    {
+        return;
+    }
+    state.minuteOpen = false;
+    size_t firstIndex = state.closedMinutes;
+    state.closedMinutes = std::max(untilIndex, state.minuteIndex + 1);
+    if (!onMinuteBar)
+    {
+        return;
+    }
+
+    // minutes before the first trade of the day repeat its open, like MinuteBarAggregator::Finish
+    const Bar& minute = state.current.minute;
+    for (size_t index = firstIndex; index < state.minuteIndex; ++index)
+    {
+        double price = minute.open;
+        onMinuteBar(symbolIndex, Bar{MakeBarTime(state.date, GetSessionMinuteLabel(index)), price, price, price, price, 0.0, 0.0});
+    }
+    onMinuteBar(symbolIndex, minute);
+    for (size_t index = state.minuteIndex + 1; index < untilIndex; ++index)
+    {
+        double price = minute.close;
+        onMinuteBar(symbolIndex, Bar{MakeBarTime(state.date, GetSessionMinuteLabel(index)), price, price, price, price, 0.0, 0.0});
+    }
+}
+
+void StockData::LiveBarBuilder::Push(const LiveTick &liveTick)
+{
+    size_t symbolIndex;
+    if (!FindSymbol(std::string(liveTick.symbol, strnlen(liveTick.symbol, SYMBOL_SIZE)), symbolIndex))
+    {
+        droppedTicks.fetch_add(1, std::memory_order_relaxed);
+        return;
+    }
+    SymbolState& state = states[symbolIndex];
+    const Tick& tick = liveTick.tick;
+
+    if (liveTick.date != state.date)
+    {
+        CloseMinutes(symbolIndex, state, SESSION_MINUTES);
+        state.current = LiveBarSnapshot{};
+        state.date = liveTick.date;
+        state.lastDayVolume = 0.0;
+        state.lastDayAmount = 0.0;
+        state.closedMinutes = 0;
+    }
+    LiveBarSnapshot& current = state.current;
+    ++current.tickCount;
+    current.lastTickTime = tick.time;
+
+    // same rules as MinuteBarAggregator::Push
+    double volume = tick.dayVolume - state.lastDayVolume;
+    double amount = tick.dayAmount - state.lastDayAmount;
+    if (volume != 0.0)
+    {
+        state.lastDayVolume = tick.dayVolume;
+        state.lastDayAmount = tick.dayAmount;
+    }
+    if (volume > 0.0 && tick.price > 0.0)
+    {
+        size_t index = GetSessionMinuteIndex(tick.time);
+        if (state.minuteOpen && index > state.minuteIndex)
+        {
+            CloseMinutes(symbolIndex, state, index);
+        }
+
+        Bar& minute = current.minute;
+        if (state.minuteOpen)
+        {
+            // late ticks of an earlier minute are folded into the open one
+            minute.high = std::max(minute.high, tick.price);
+            minute.low = std::min(minute.low, tick.price);
+            minute.close = tick.price;
+            minute.volume += volume;
+            minute.amount += amount;
+        }
+        else if (index >= state.closedMinutes)
+        {
+            minute = Bar{MakeBarTime(state.date, GetSessionMinuteLabel(index)), tick.price, tick.price, tick.price, tick.price, volume, amount};
+            state.minuteIndex = index;
+            state.minuteOpen = true;
+        }
+        else
+        {
+            // the minute was already passed to onMinuteBar, e.g. after FinishDay, reopening it would pass it twice
+            lateTicks.fetch_add(1, std::memory_order_relaxed);
+        }
+
+        Bar& day = current.day;
+        if (day.time == 0)
+        {
+            day = Bar{state.date, tick.price, tick.price, tick.price, tick.price, 0.0, 0.0};
+        }
+        day.high = std::max(day.high, tick.price);
+        day.low = std::min(day.low, tick.price);
+        day.close = tick.price;
+        day.volume = tick.dayVolume;
+        day.amount = tick.dayAmount;
+    }
+
+    state.published.Store(current);
+}
+
+void StockData::LiveBarBuilder::FinishDay()
+{
+    for (size_t i = 0; i < symbols.size(); ++i)
+    {
+        CloseMinutes(i, states[i], SESSION_MINUTES);
+    }
+}
+
+StockData::LiveIngest::LiveIngest(const std::vector<std::string> &symbols, size_t capacity, bool consumerSleeps)
+    : builder(symbols), ringCapacity(capacity), sleepWhenIdle(consumerSleeps)
+{}
+
+StockData::LiveIngest::~LiveIngest()
+{
+    Stop();
+}
+
+bool StockData::LiveIngest::Start(const std::vector<int> &feedDescriptors)
+{
+    if (consumer.joinable())
+    {
+        return false;
+    }
+
+    feeds = feedDescriptors;
+    rings.clear();
+    for (size_t i = 0; i < feeds.size(); ++i)
+    {
+        rings.push_back(std::make_unique<SpscRing<LiveTick>>(ringCapacity));
+    }
+    stopping = false;
+    finishedFeeds = 0;
+    receivedTicks = 0;
+    processedTicks = 0;
+
+    consumer = std::thread(&LiveIngest::Consume, this);
+    for (size_t i = 0; i < feeds.size(); ++i)
+    {
+        readers.emplace_back(&LiveIngest::ReadFeed, this, i);
+    }
+    return true;
+}
+
+bool StockData::LiveIngest::Start(const std::vector<std::string> &feedPaths, std::string &error)
+{
+    std::vector<int> descriptors;
+    for (const std::string& path : feedPaths)
+    {
+        int fd;
+        if (!OpenFeed(path, fd, error))
+        {
+            for (int opened : descriptors)
+            {
+                close(opened);
+            }
+            return false;
+        }
+        descriptors.push_back(fd);
+    }
+    if (!Start(descriptors))
+    {
+        error = "Live ingest already started";
+        for (int opened : descriptors)
+        {
+            close(opened);
+        }
+        return false;
+    }
+    return true;
+}
+
+void StockData::LiveIngest::WaitForFeeds()
+{
+    // rings, unlike feeds, is not cleared by Stop
+    IdleBackoff backoff;
+    while (!stopping.load(std::memory_order_acquire)
+           && (finishedFeeds.load(std::memory_order_acquire) < rings.size() || ProcessedTicks() < ReceivedTicks()))
+    {
+        backoff.Wait();
+    }
+}
+
+void StockData::LiveIngest::Stop()
+{
+    stopping = true;
+    for (std::thread& reader : readers)
+    {
+        reader.join();
+    }
+    readers.clear();
+    if (consumer.joinable())
+    {
+        consumer.join();
+    }
+    for (int fd : feeds)
+    {
+        close(fd);
+    }
+    feeds.clear();
+}
+
+void StockData::LiveIngest::ReadFeed(size_t feedIndex)
+{
+    const int fd = feeds[feedIndex];
+    SpscRing<LiveTick>& ring = *rings[feedIndex];
+
+    // records can be split across reads, the tail of a read is kept for the next one
+    char buffer[READ_BATCH_TICKS * sizeof(LiveTick)];
+    size_t buffered = 0;
+    while (!stopping.load(std::memory_order_relaxed))
+    {
+        pollfd request{fd, POLLIN, 0};
+        int ready = poll(&request, 1, POLL_TIMEOUT_MS);
+        if (ready == 0 || (ready < 0 && errno == EINTR))
+        {
+            continue;
+        }
+        ssize_t bytesRead = ready > 0 ? read(fd, buffer + buffered, sizeof(buffer) - buffered) : -1;
+        if (bytesRead < 0 && errno == EINTR)
+        {
+            continue;
+        }
+        if (bytesRead <= 0)
+        {
+            break; // end of the feed or an error
+        }
+        buffered += bytesRead;
+
+        size_t tickCount = buffered / sizeof(LiveTick);
+        bool stopped = false;
+        for (size_t i = 0; i < tickCount && !stopped; ++i)
+        {
+            LiveTick liveTick;
+            memcpy(&liveTick, buffer + i * sizeof(LiveTick), sizeof(LiveTick));
+            IdleBackoff backoff;
+            while (!ring.TryPush(liveTick))
+            {
+                if (stopping.load(std::memory_order_relaxed))
+                {
+                    stopped = true;
+                    break;
+                }
+                backoff.Wait();
+            }
+            if (!stopped)
+            {
+                receivedTicks.fetch_add(1, std::memory_order_release); // only once it is in the ring, for WaitForFeeds
+            }
+        }
+        if (stopped)
+        {
+            break;
+        }
+        buffered -= tickCount * sizeof(LiveTick);
+        memmove(buffer, buffer + tickCount * sizeof(LiveTick), buffered);
+    }
+    finishedFeeds.fetch_add(1, std::memory_order_release);
+}
+
+void StockData::LiveIngest::Consume()
+{
+    IdleBackoff backoff;
+    backoff.sleeps = sleepWhenIdle;
+    LiveTick liveTick;
+    while (!stopping.load(std::memory_order_relaxed))
+    {
+        bool any = false;
+        for (auto& ring : rings)
+        {
+            for (size_t i = 0; i < CONSUMER_BURST && ring->TryPop(liveTick); ++i)
+            {
+                builder.Push(liveTick);
+                processedTicks.fetch_add(1, std::memory_order_release);
+                any = true;
+            }
+        }
+
+        // spin to keep the latency of the next tick low, and only back off when asked to
+        if (any)
+        {
+            backoff.Reset();
+        }
+        else
+        {
+            backoff.Wait();
+        }
+    }
+}
+
+bool StockData::OpenFeed(const std::string &path, int &fd, std::string &error)
+{
+    struct stat status;
+    if (stat(path.c_str(), &status) != 0)
+    {
+        error = "Failed to open feed: " + path + ": " + strerror(errno);
+        return false;
+    }
+
+    if (S_ISSOCK(status.st_mode))
+    {
+        sockaddr_un address{};
+        address.sun_family = AF_UNIX;
+        if (path.size() >= sizeof(address.sun_path))
+        {
+            error = "Socket path too long: " + path;
+            return false;
+        }
+        memcpy(address.sun_path, path.c_str(), path.size() + 1);
+
+        fd = socket(AF_UNIX, SOCK_STREAM, 0);
+        if (fd < 0 || connect(fd, reinterpret_cast<const sockaddr*>(&address), sizeof(address)) != 0)
+        {
+            error = "Failed to connect to feed: " + path + ": " + strerror(errno);
+            if (fd >= 0)
+            {
+                close(fd);
+            }
+            return false;
+        }
+        return true;
+    }
+
+    // opening a named pipe blocks until the writer opens it too
+    fd = open(path.c_str(), O_RDONLY);
+    if (fd < 0)
+    {
+        error = "Failed to open feed: " + path + ": " + strerror(errno);
+        return false;
+    }
+    return true;
+}
+
+bool StockData::ReplayTicks(const std::string &tickFilePath, int fd, std::string &error)
+{
+    TickStream stream;
+    if (!stream.Open(tickFilePath))
+    {
+        error = "Failed to open file: " + tickFilePath;
+        return false;
+    }
+
+    std::vector<LiveTick> liveTicks;
+    for (auto batch = stream.NextBatch(); !batch.empty(); batch = stream.NextBatch())
+    {
+        liveTicks.resize(batch.size());
+        for (size_t i = 0; i < batch.size(); ++i)
+        {
+            memcpy(liveTicks[i].symbol, stream.symbol, SYMBOL_SIZE);
+            liveTicks[i].date = stream.date;
+            liveTicks[i].tick = batch[i];
+        }
+        if (!WriteAll(fd, liveTicks.data(), liveTicks.size() * sizeof(LiveTick)))
+        {
+            error = "Failed to write to feed: " + std::string(strerror(errno));
+            return false;
+        }
+    }
+    return true;
+}
@@ -0,0 +1,149 @@
+#pragma once
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+#include <functional>
+#include <memory>
+#include <string>
+#include <thread>
+#include <unordered_map>
+#include <vector>
+
+#include "Lockfree.hpp"
+#include "StockData.hpp"
+
+namespace StockData
+{
+    /// @brief A tick as it travels on a live feed: the raw bytes of this struct, back to back
+    struct LiveTick
+    {
+        char symbol[SYMBOL_SIZE];
+        uint64_t date; // e.g. 20240105
+        Tick tick;
+    };
+
+    /// @brief Bars of a symbol as of its last tick. minute.time is 0 until something traded.
+    /// The minute bar is timed like MinuteBarAggregator's (YYYYMMDDHHMMSS of its end), the day bar YYYYMMDD
+    struct LiveBarSnapshot
+    {
+        Bar minute;
+        Bar day;
+        uint64_t tickCount; // ticks of the day, quotes included
+        uint64_t lastTickTime;
+    };
+
+    /// @brief Updates the current 1m and 1d bar of each symbol tick by tick, with the same rules as MinuteBarAggregator,
+    /// and publishes them through a seqlock per symbol. Push must be called from a single thread, snapshots can be read from any thread
+    struct LiveBarBuilder
+    {
+        /// @param symbols the symbols to follow, ticks of other symbols are counted and dropped
+        explicit LiveBarBuilder(const std::vector<std::string>& symbols);
+
+        /// @brief Called by Push for every minute bar that is complete, minutes without trades repeat the last close
+        /// (the open before the first trade), so a day gives the SESSION_MINUTES bars of MinuteBarAggregator.
+        /// Runs on the thread calling Push, so it should be quick
+        std::function<void(size_t symbolIndex, const Bar& bar)> onMinuteBar;
+
+        size_t SymbolCount() const { return symbols.size(); }
+        const std::string& Symbol(size_t symbolIndex) const { return symbols[symbolIndex]; }
+
+        /// @return true if the symbol is followed, false otherwise
+        bool FindSymbol(const std::string& symbol, size_t& symbolIndex) const;
+
+        void Push(const LiveTick& liveTick);
+
+        /// @brief Complete the minute bars in progress and the minutes left until the close, e.g. after the close.
+        /// Trades pushed later for the same day count in the day bar only, see LateTicks
+        void FinishDay();
+
+        /// @brief Latest bars of a symbol, lock-free
+        LiveBarSnapshot GetSnapshot(size_t symbolIndex) const { return states[symbolIndex].published.Load(); }
+
+        uint64_t DroppedTicks() const { return droppedTicks.load(std::memory_order_relaxed); }
+
+        /// @brief Trades of a minute already passed to onMinuteBar, left out of the minute bars
+        uint64_t LateTicks() const { return lateTicks.load(std::memory_order_relaxed); }
+
+    private:
+        struct SymbolState
+        {
+            SeqLock<LiveBarSnapshot> published;
+            LiveBarSnapshot current{};
+            uint64_t date = 0;
+            double lastDayVolume = 0.0;
+            double lastDayAmount = 0.0;
+            size_t minuteIndex = 0;
+            size_t closedMinutes = 0; // minutes [0, closedMinutes) of the day were passed to onMinuteBar
+            bool minuteOpen = false;  // current.minute has trades and was not passed to onMinuteBar yet
+        };
+
+        /// @brief Pass the open minute and the minutes without trades before untilIndex to onMinuteBar
+        void CloseMinutes(size_t symbolIndex, SymbolState& state, size_t untilIndex);
+
+        std::vector<std::string> symbols;
+        std::unordered_map<std::string, size_t> symbolIndices;
+        std::unique_ptr<SymbolState[]> states;
+        std::atomic<uint64_t> droppedTicks{0};
+        std::atomic<uint64_t> lateTicks{0};
+    };
+
+    /// @brief Live ingest: one reader thread per feed, each pushing into its own SPSC ring,
+    /// and one consumer thread draining the rings into a LiveBarBuilder
+    struct LiveIngest
+    {
+        static constexpr size_t DEFAULT_RING_CAPACITY = 1 << 16;
+
+        /// @param symbols see LiveBarBuilder
+        /// @param ringCapacity ticks per feed ring, a reader waits for room when its ring is full
+        /// @param sleepWhenIdle let the consumer sleep (up to 1 ms) once the feeds go quiet, to free its core at the cost of
+        /// the latency of the first tick after a quiet spell. By default it keeps spinning, so ticks reach the builder within microseconds
+        explicit LiveIngest(const std::vector<std::string>& symbols, size_t ringCapacity = DEFAULT_RING_CAPACITY, bool sleepWhenIdle = false);
+        ~LiveIngest();
+
+        LiveIngest(const LiveIngest&) = delete;
+        LiveIngest& operator=(const LiveIngest&) = delete;
+
+        LiveBarBuilder builder;
+
+        /// @brief Start reading the feeds, the descriptors are owned by the ingest from now on
+        /// @param feeds readable file descriptors, e.g. pipes or connected sockets
+        /// @return false if already started
+        bool Start(const std::vector<int>& feeds);
+
+        /// @brief Open the feeds (named pipes or Unix domain sockets, see OpenFeed) and start reading them
+        /// @return false if a feed could not be opened, nothing is started then
+        bool Start(const std::vector<std::string>& feedPaths, std::string& error);
+
+        /// @brief Wait until every feed reached its end and every tick received went through the builder, or until Stop
+        void WaitForFeeds();
+
+        /// @brief Stop the threads and close the feeds, ticks still in the rings are dropped
+        void Stop();
+
+        uint64_t ReceivedTicks() const { return receivedTicks.load(std::memory_order_acquire); }
+        uint64_t ProcessedTicks() const { return processedTicks.load(std::memory_order_acquire); }
+
+    private:
+        void ReadFeed(size_t feedIndex);
+        void Consume();
+
+        size_t ringCapacity;
+        bool sleepWhenIdle;
+        std::vector<int> feeds;
+        std::vector<std::unique_ptr<SpscRing<LiveTick>>> rings;
+        std::vector<std::thread> readers;
+        std::thread consumer;
+        std::atomic<bool> stopping{false};
+        std::atomic<size_t> finishedFeeds{0};
+        std::atomic<uint64_t> receivedTicks{0};
+        std::atomic<uint64_t> processedTicks{0};
+    };
+
+    /// @brief Open a feed for reading: a Unix domain socket is connected to, anything else (e.g. a named pipe) is opened
+    /// @return true if the feed was opened, false otherwise
+    bool OpenFeed(const std::string& path, int& fd, std::string& error);
+
+    /// @brief Write the ticks of a tick file to a feed as LiveTicks, e.g. to stand in for the live feed
+    /// @return true if every tick was written, false otherwise
+    bool ReplayTicks(const std::string& tickFilePath, int fd, std::string& error);
+}
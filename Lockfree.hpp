@@ -0,0 +1,136 @@
+#pragma once
+#include <algorithm>
+#include <atomic>
+#include <bit>
+#include <cstddef>
+#include <cstdint>
+#include <cstring>
+#include <type_traits>
+#include <vector>
+
+namespace StockData
+{
+    constexpr size_t CACHE_LINE_SIZE = 64;
+
+    /// @brief Bounded lock-free queue for exactly one producer thread and one consumer thread.
+    /// Each side caches the other side's index, so the shared cache lines are only touched when the cached view runs out
+    template <typename T>
+    struct SpscRing
+    {
+        /// @param capacity rounded up to a power of two
+        explicit SpscRing(size_t capacity)
+            : slots(std::bit_ceil(std::max<size_t>(capacity, 2))), mask(slots.size() - 1)
+        {}
+
+        SpscRing(const SpscRing&) = delete;
+        SpscRing& operator=(const SpscRing&) = delete;
+
+        size_t Capacity() const { return slots.size(); }
+
+        /// @brief Producer side
+        /// @return false if the ring is full
+        bool TryPush(const T& value)
+        {
+            size_t position = tail.load(std::memory_order_relaxed);
+            if (position - cachedHead == slots.size())
+            {
+                cachedHead = head.load(std::memory_order_acquire);
+                if (position - cachedHead == slots.size())
+                {
+                    return false;
+                }
+            }
+            slots[position & mask] = value;
+            tail.store(position + 1, std::memory_order_release);
+            return true;
+        }
+
+        /// @brief Consumer side
+        /// @return false if the ring is empty
+        bool TryPop(T& value)
+        {
+            size_t position = head.load(std::memory_order_relaxed);
+            if (position == cachedTail)
+            {
+                cachedTail = tail.load(std::memory_order_acquire);
+                if (position == cachedTail)
+                {
+                    return false;
+                }
+            }
+            value = slots[position & mask];
+            head.store(position + 1, std::memory_order_release);
+            return true;
+        }
+
+        /// @brief Approximate when called concurrently with the producer or the consumer
+        bool Empty() const { return head.load(std::memory_order_acquire) == tail.load(std::memory_order_acquire); }
+
+    private:
+        std::vector<T> slots;
+        size_t mask;
+        alignas(CACHE_LINE_SIZE) std::atomic<size_t> head{0}; // next slot to pop, written by the consumer
+        size_t cachedTail = 0;                                 // consumer's view of tail
+        alignas(CACHE_LINE_SIZE) std::atomic<size_t> tail{0}; // next slot to push, written by the producer
+        size_t cachedHead = 0;                                 // producer's view of head
+    };
+
+    /// @brief Single writer, many readers value that readers copy without taking a lock and without blocking the writer.
+    /// A reader retries when the writer published in the middle of its copy.
+    /// The value is kept in relaxed atomic words, so concurrent copies are well defined
+    template <typename T>
+    struct SeqLock
+    {
+        static_assert(std::is_trivially_copyable_v<T>);
+        static constexpr size_t WORD_COUNT = (sizeof(T) + sizeof(uint64_t) - 1) / sizeof(uint64_t);
+
+        /// @brief Writer side
+        void Store(const T& value)
+        {
+            uint64_t buffer[WORD_COUNT] = {};
+            memcpy(buffer, &value, sizeof(T));
+
+            uint64_t sequence = version.load(std::memory_order_relaxed);
+            version.store(sequence + 1, std::memory_order_relaxed);
+            std::atomic_thread_fence(std::memory_order_release);
+            for (size_t i = 0; i < WORD_COUNT; ++i)
+            {
+                words[i].store(buffer[i], std::memory_order_relaxed);
+            }
+            version.store(sequence + 2, std::memory_order_release);
+        }
+
+        /// @brief Reader side, from any thread
+        T Load() const
+        {
+            uint64_t buffer[WORD_COUNT];
+            for (;;)
+            {
+                uint64_t before = version.load(std::memory_order_acquire);
+                if (before & 1)
+                {
+                    continue; // a write is in progress
+                }
+                for (size_t i = 0; i < WORD_COUNT; ++i)
+                {
+                    buffer[i] = words[i].load(std::memory_order_relaxed);
+                }
+                std::atomic_thread_fence(std::memory_order_acquire);
+                if (version.load(std::memory_order_relaxed) == before)
+                {
+                    break;
+                }
+            }
+            T value;
+            memcpy(&value, buffer, sizeof(T));
+            return value;
+        }
+
+        /// @brief Number of values stored so far
+        uint64_t Version() const { return version.load(std::memory_order_acquire) / 2; }
+
+    private:
+        alignas(CACHE_LINE_SIZE) std::atomic<uint64_t> version{0};
+        std::atomic<uint64_t> words[WORD_COUNT] = {};
+    };
+}
@@ -0,0 +1,306 @@
+#include "Metrics.hpp"
+#include <algorithm>
+#include <atomic>
+#include <bit>
+#include <condition_variable>
+#include <iomanip>
+#include <memory>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+namespace
+{
+    using StockData::LatencyHistogram;
+    using StockData::METRIC_OPERATION_COUNT;
+    using StockData::MetricOperation;
+    using StockData::MetricsSnapshot;
+
+    /// @brief Counters of one thread. Only the owning thread writes them, with a plain load and store instead of an atomic add,
+    /// so recording costs no more than a non-atomic counter; other threads only read them
+    struct ThreadCounters
+    {
+        std::atomic<uint64_t> calls[METRIC_OPERATION_COUNT] = {};
+        std::atomic<uint64_t> filesOpened[METRIC_OPERATION_COUNT] = {};
+        std::atomic<uint64_t> bytesRead[METRIC_OPERATION_COUNT] = {};
+        std::atomic<uint64_t> totalNanoseconds[METRIC_OPERATION_COUNT] = {};
+        std::atomic<uint64_t> latency[METRIC_OPERATION_COUNT][LatencyHistogram::BUCKET_COUNT] = {};
+    };
+
+    void Increase(std::atomic<uint64_t>& counter, uint64_t value)
+    {
+        counter.store(counter.load(std::memory_order_relaxed) + value, std::memory_order_relaxed);
+    }
+
+    void AddCounters(const ThreadCounters& counters, MetricsSnapshot& snapshot)
+    {
+        for (size_t i = 0; i < METRIC_OPERATION_COUNT; ++i)
+        {
+            auto& operation = snapshot.operations[i];
+            operation.calls += counters.calls[i].load(std::memory_order_relaxed);
+            operation.filesOpened += counters.filesOpened[i].load(std::memory_order_relaxed);
+            operation.bytesRead += counters.bytesRead[i].load(std::memory_order_relaxed);
+            operation.totalNanoseconds += counters.totalNanoseconds[i].load(std::memory_order_relaxed);
+            for (size_t bucket = 0; bucket < LatencyHistogram::BUCKET_COUNT; ++bucket)
+            {
+                operation.latency.counts[bucket] += counters.latency[i][bucket].load(std::memory_order_relaxed);
+            }
+        }
+    }
+
+    void SubtractSnapshot(const MetricsSnapshot& baseline, MetricsSnapshot& snapshot)
+    {
+        for (size_t i = 0; i < METRIC_OPERATION_COUNT; ++i)
+        {
+            auto& operation = snapshot.operations[i];
+            const auto& base = baseline.operations[i];
+            operation.calls -= base.calls;
+            operation.filesOpened -= base.filesOpened;
+            operation.bytesRead -= base.bytesRead;
+            operation.totalNanoseconds -= base.totalNanoseconds;
+            for (size_t bucket = 0; bucket < LatencyHistogram::BUCKET_COUNT; ++bucket)
+            {
+                operation.latency.counts[bucket] -= base.latency.counts[bucket];
+            }
+        }
+    }
+
+    /// @brief Counters of the running threads, plus the totals of the threads that exited.
+    /// Counters only ever grow, ResetMetrics moves the baseline that snapshots are taken against
+    struct MetricsRegistry
+    {
+        std::mutex mutex;
+        std::vector<const ThreadCounters*> threads;
+        MetricsSnapshot exited;
+        MetricsSnapshot baseline;
+    };
+
+    MetricsRegistry& GetRegistry()
+    {
+        // never destroyed, threads may still exit after static destructors ran
+        static MetricsRegistry* registry = new MetricsRegistry();
+        return *registry;
+    }
+
+    struct ThreadSlot
+    {
+        std::unique_ptr<ThreadCounters> counters = std::make_unique<ThreadCounters>();
+
+        ThreadSlot()
+        {
+            MetricsRegistry& registry = GetRegistry();
+            std::lock_guard lock(registry.mutex);
+            registry.threads.push_back(counters.get());
+        }
+
+        ~ThreadSlot()
+        {
+            MetricsRegistry& registry = GetRegistry();
+            std::lock_guard lock(registry.mutex);
+            AddCounters(*counters, registry.exited);
+            std::erase(registry.threads, counters.get());
+        }
+    };
+
+    ThreadCounters& GetThreadCounters()
+    {
+        thread_local ThreadSlot slot;
+        return *slot.counters;
+    }
+
+    void CollectMetrics(MetricsRegistry& registry, MetricsSnapshot& snapshot)
+    {
+        snapshot = registry.exited;
+        for (const ThreadCounters* counters : registry.threads)
+        {
+            AddCounters(*counters, snapshot);
+        }
+    }
+
+    struct MetricsDump
+    {
+        std::mutex mutex;
+        std::condition_variable stopped;
+        bool stopping = false;
+        std::thread thread;
+    };
+
+    MetricsDump& GetMetricsDump()
+    {
+        // never destroyed either, a dump still running at exit must not terminate the process
+        static MetricsDump* dump = new MetricsDump();
+        return *dump;
+    }
+}
+
+const char* StockData::GetMetricOperationName(MetricOperation operation)
+{
+    switch (operation)
+    {
+        case MetricOperation::ReadBars:
+            return "ReadBars";
+        case MetricOperation::ReadTicks:
+            return "ReadTicks";
+        case MetricOperation::GetNBarsFromDate:
+            return "GetNBarsFromDate";
+        case MetricOperation::Normalize:
+            return "Normalize";
+        default:
+            return "Unknown";
+    }
+}
+
+size_t StockData::LatencyHistogram::GetBucketIndex(uint64_t value)
+{
+    if (value < 2 * SUB_BUCKET_COUNT)
+    {
+        return value;
+    }
+    size_t shift = std::bit_width(value) - (SUB_BUCKET_BITS + 1);
+    size_t subBucket = (value >> shift) - SUB_BUCKET_COUNT;
+    return 2 * SUB_BUCKET_COUNT + (shift - 1) * SUB_BUCKET_COUNT + subBucket;
+}
+
+uint64_t StockData::LatencyHistogram::GetBucketUpperBound(size_t index)
+{
+    if (index < 2 * SUB_BUCKET_COUNT)
+    {
+        return index;
+    }
+    size_t shift = (index - 2 * SUB_BUCKET_COUNT) / SUB_BUCKET_COUNT + 1;
+    uint64_t subBucket = (index - 2 * SUB_BUCKET_COUNT) % SUB_BUCKET_COUNT + SUB_BUCKET_COUNT;
+    return ((subBucket + 1) << shift) - 1;
+}
+
+uint64_t StockData::LatencyHistogram::Count() const
+{
+    uint64_t count = 0;
+    for (uint64_t bucketCount : counts)
+    {
+        count += bucketCount;
+    }
+    return count;
+}
+
+uint64_t StockData::LatencyHistogram::Percentile(double fraction) const
+{
+    uint64_t count = Count();
+    if (count == 0)
+    {
+        return 0;
+    }
+
+    uint64_t rank = std::max<uint64_t>(1, uint64_t(std::clamp(fraction, 0.0, 1.0) * count + 0.5));
+    uint64_t seen = 0;
+    for (size_t i = 0; i < BUCKET_COUNT; ++i)
+    {
+        seen += counts[i];
+        if (seen >= rank)
+        {
+            return GetBucketUpperBound(i);
+        }
+    }
+    return Max();
+}
+
+uint64_t StockData::LatencyHistogram::Max() const
+{
+    for (size_t i = BUCKET_COUNT; i-- > 0;)
+    {
+        if (counts[i] > 0)
+        {
+            return GetBucketUpperBound(i);
+        }
+    }
+    return 0;
+}
+
+void StockData::RecordMetricCall(MetricOperation operation, uint64_t nanoseconds)
+{
+    size_t i = static_cast<size_t>(operation);
+    ThreadCounters& counters = GetThreadCounters();
+    Increase(counters.calls[i], 1);
+    Increase(counters.totalNanoseconds[i], nanoseconds);
+    Increase(counters.latency[i][LatencyHistogram::GetBucketIndex(nanoseconds)], 1);
+}
+
+void StockData::RecordMetricIo(MetricOperation operation, uint64_t bytesRead, uint64_t filesOpened)
+{
+    size_t i = static_cast<size_t>(operation);
+    ThreadCounters& counters = GetThreadCounters();
+    Increase(counters.bytesRead[i], bytesRead);
+    Increase(counters.filesOpened[i], filesOpened);
+}
+
+void StockData::GetMetrics(MetricsSnapshot &snapshot)
+{
+    MetricsRegistry& registry = GetRegistry();
+    std::lock_guard lock(registry.mutex);
+    CollectMetrics(registry, snapshot);
+    SubtractSnapshot(registry.baseline, snapshot);
+}
+
+void StockData::ResetMetrics()
+{
+    MetricsRegistry& registry = GetRegistry();
+    std::lock_guard lock(registry.mutex);
+    CollectMetrics(registry, registry.baseline);
+}
+
+void StockData::DumpMetrics(std::ostream &stream)
+{
+    auto snapshot = std::make_unique<MetricsSnapshot>(); // too large for the stack of a small thread
+    GetMetrics(*snapshot);
+
+    auto microseconds = [](double nanoseconds) { return nanoseconds / 1000.0; };
+    for (size_t i = 0; i < METRIC_OPERATION_COUNT; ++i)
+    {
+        const OperationMetrics& operation = snapshot->operations[i];
+        if (operation.calls == 0)
+        {
+            continue;
+        }
+        stream << GetMetricOperationName(static_cast<MetricOperation>(i))
+               << " calls=" << operation.calls
+               << " files=" << operation.filesOpened
+               << " bytes=" << operation.bytesRead
+               << std::fixed << std::setprecision(1)
+               << " mean=" << microseconds(operation.MeanNanoseconds()) << "us"
+               << " p50=" << microseconds(operation.latency.Percentile(0.5)) << "us"
+               << " p99=" << microseconds(operation.latency.Percentile(0.99)) << "us"
+               << " max=" << microseconds(operation.latency.Max()) << "us"
+               << std::defaultfloat << '\n';
+    }
+    stream.flush();
+}
+
+void StockData::StartMetricsDump(std::chrono::milliseconds period, std::ostream &stream)
+{
+    StopMetricsDump();
+
+    MetricsDump& dump = GetMetricsDump();
+    dump.stopping = false;
+    dump.thread = std::thread([&dump, period, &stream]()
+    {
+        std::unique_lock lock(dump.mutex);
+        while (!dump.stopped.wait_for(lock, period, [&dump]() { return dump.stopping; }))
+        {
+            DumpMetrics(stream);
+        }
+    });
+}
+
+void StockData::StopMetricsDump()
+{
+    MetricsDump& dump = GetMetricsDump();
+    if (!dump.thread.joinable())
+    {
+        return;
+    }
+    {
+        std::lock_guard lock(dump.mutex);
+        dump.stopping = true;
+    }
+    dump.stopped.notify_all();
+    dump.thread.join();
+}
@@ -0,0 +1,129 @@
+#pragma once
+#include <chrono>
+#include <cstddef>
+#include <cstdint>
+#include <iostream>
+
+// Loader instrumentation. Build everything with -DSTOCKDATA_METRICS to turn it on: the STOCKDATA_METRIC_* hooks
+// in the loaders then record into per-thread counters, otherwise they expand to nothing and the snapshots stay empty.
+// The define has to be the same for every translation unit, the hooks are also used in inline functions of StockData.hpp
+
+namespace StockData
+{
+    enum class MetricOperation
+    {
+        ReadBars = 0,
+        ReadTicks,
+        GetNBarsFromDate,
+        Normalize,
+        Count
+    };
+
+    constexpr size_t METRIC_OPERATION_COUNT = static_cast<size_t>(MetricOperation::Count);
+
+    const char* GetMetricOperationName(MetricOperation operation);
+
+    /// @brief Latency histogram in nanoseconds with HDR-style buckets: exact below 16, then 8 buckets per power of two,
+    /// so any recorded value is known to within 12.5%
+    struct LatencyHistogram
+    {
+        static constexpr size_t SUB_BUCKET_BITS = 3;
+        static constexpr size_t SUB_BUCKET_COUNT = size_t(1) << SUB_BUCKET_BITS;
+        static constexpr size_t BUCKET_COUNT = 2 * SUB_BUCKET_COUNT + (64 - SUB_BUCKET_BITS - 1) * SUB_BUCKET_COUNT;
+
+        uint64_t counts[BUCKET_COUNT] = {};
+
+        static size_t GetBucketIndex(uint64_t value);
+        /// @brief Largest value that falls into the bucket
+        static uint64_t GetBucketUpperBound(size_t index);
+
+        uint64_t Count() const;
+
+        /// @brief Value below which the given fraction of the recorded values fall, rounded up to its bucket
+        /// @param fraction in [0, 1], e.g. 0.99
+        /// @return 0 if nothing was recorded
+        uint64_t Percentile(double fraction) const;
+
+        /// @brief Upper bound of the highest non-empty bucket, 0 if nothing was recorded
+        uint64_t Max() const;
+    };
+
+    struct OperationMetrics
+    {
+        uint64_t calls = 0;
+        uint64_t filesOpened = 0;
+        uint64_t bytesRead = 0;
+        uint64_t totalNanoseconds = 0;
+        LatencyHistogram latency;
+
+        double MeanNanoseconds() const { return calls > 0 ? double(totalNanoseconds) / calls : 0.0; }
+    };
+
+    /// @brief Metrics of every thread, past and present, since the start of the process or the last ResetMetrics
+    struct MetricsSnapshot
+    {
+        OperationMetrics operations[METRIC_OPERATION_COUNT];
+
+        const OperationMetrics& Get(MetricOperation operation) const { return operations[static_cast<size_t>(operation)]; }
+    };
+
+    constexpr bool MetricsEnabled()
+    {
+#ifdef STOCKDATA_METRICS
+        return true;
+#else
+        return false;
+#endif
+    }
+
+    /// @brief Record a completed call on the calling thread, used by MetricScope
+    void RecordMetricCall(MetricOperation operation, uint64_t nanoseconds);
+
+    /// @brief Record file activity of an operation on the calling thread
+    void RecordMetricIo(MetricOperation operation, uint64_t bytesRead, uint64_t filesOpened);
+
+    /// @brief Add up the counters of all threads. Counters are only read, so the threads being measured are never blocked
+    void GetMetrics(MetricsSnapshot& snapshot);
+
+    /// @brief Start counting from zero again
+    void ResetMetrics();
+
+    /// @brief Write one line per operation that was called, e.g.
+    /// "ReadBars calls=12 files=12 bytes=1048576 mean=85.2us p50=80us p99=150us max=160us"
+    void DumpMetrics(std::ostream& stream);
+
+    /// @brief Call DumpMetrics on a background thread every period, until StopMetricsDump. Restarts the dump if already running
+    /// @param stream must outlive the dump
+    void StartMetricsDump(std::chrono::milliseconds period, std::ostream& stream = std::cerr);
+
+    void StopMetricsDump();
+
+    /// @brief Times its own lifetime and records it as one call of an operation
+    struct MetricScope
+    {
+        explicit MetricScope(MetricOperation operation)
+            : operation(operation), start(std::chrono::steady_clock::now())
+        {}
+
+        ~MetricScope()
+        {
+            auto elapsed = std::chrono::steady_clock::now() - start;
+            RecordMetricCall(operation, std::chrono::duration_cast<std::chrono::nanoseconds>(elapsed).count());
+        }
+
+        MetricScope(const MetricScope&) = delete;
+        MetricScope& operator=(const MetricScope&) = delete;
+
+    private:
+        MetricOperation operation;
+        std::chrono::steady_clock::time_point start;
+    };
+}
+
+#ifdef STOCKDATA_METRICS
+#define STOCKDATA_METRIC_SCOPE(operation) StockData::MetricScope stockDataMetricScope(StockData::MetricOperation::operation)
+#define STOCKDATA_METRIC_IO(operation, bytesRead, filesOpened) StockData::RecordMetricIo(StockData::MetricOperation::operation, bytesRead, filesOpened)
+#else
+#define STOCKDATA_METRIC_SCOPE(operation) ((void)0)
+#define STOCKDATA_METRIC_IO(operation, bytesRead, filesOpened) ((void)0)
+#endif
@@ -0,0 +1,189 @@
+#include "StockData.hpp"
+#include <cstddef>
+#include <limits>
+
+#if defined(__x86_64__) || defined(__i386__)
+#include <immintrin.h>
+#define STOCKDATA_NORMALIZE_AVX2 1
+#endif
+
+namespace
+{
+    using StockData::AugmentedBar;
+
+    void NormalizeScalar(AugmentedBar* bars, size_t count)
+    {
+        // find max and min
+        double priceMax = 0.0;
+        double priceMin = std::numeric_limits<double>::max();
+        double volumeMax = 0.0;
+        double volumeMin = std::numeric_limits<double>::max();
+        double amountMax = 0.0;
+        double amountMin = std::numeric_limits<double>::max();
+        for (size_t i = 0; i < count; ++i)
+        {
+            const AugmentedBar& bar = bars[i];
+            if (bar.high > priceMax) priceMax = bar.high;
+            if (bar.low < priceMin) priceMin = bar.low;
+            if (bar.volume > volumeMax) volumeMax = bar.volume;
+            if (bar.volume < volumeMin) volumeMin = bar.volume;
+            if (bar.amount > amountMax) amountMax = bar.amount;
+            if (bar.amount < amountMin) amountMin = bar.amount;
+        }
+
+        double priceRange = priceMax - priceMin;
+        double volumeRange = volumeMax - volumeMin;
+        double amountRange = amountMax - amountMin;
+
+        for (size_t i = 0; i < count; ++i)
+        {
+            AugmentedBar& bar = bars[i];
+            if (priceRange != 0.0)
+            {
+                bar.openNormalized = (bar.open - priceMin) / priceRange;
+                bar.highNormalized = (bar.high - priceMin) / priceRange;
+                bar.lowNormalized = (bar.low - priceMin) / priceRange;
+                bar.closeNormalized = (bar.close - priceMin) / priceRange;
+                bar.averageNormalized = (bar.average - priceMin) / priceRange;
+            }
+            else
+            {
+                bar.openNormalized = 0.0;
+                bar.highNormalized = 0.0;
+                bar.lowNormalized = 0.0;
+                bar.closeNormalized = 0.0;
+                bar.averageNormalized = 0.0;
+            }
+
+            if (volumeRange != 0.0)
+            {
+                bar.volumeNormalized = (bar.volume - volumeMin) / volumeRange;
+            }
+            else
+            {
+                bar.volumeNormalized = 0.0;
+            }
+
+            if (amountRange != 0.0)
+            {
+                bar.amountNormalized = (bar.amount - amountMin) / amountRange;
+            }
+            else
+            {
+                bar.amountNormalized = 0.0;
+            }
+        }
+    }
+
+#ifdef STOCKDATA_NORMALIZE_AVX2
+    // Every raw field is directly followed by its normalized field, so a 256 bits load at &open gives
+    // [open, openNormalized, high, highNormalized], and likewise from &low, &average and &amount.
+    // Each field keeps its own lane and bars are visited in order, so min/max see exactly the same
+    // sequence of comparisons as the scalar code, and the normalized values are the same divisions.
+    static_assert(offsetof(AugmentedBar, openNormalized) == offsetof(AugmentedBar, open) + sizeof(double));
+    static_assert(offsetof(AugmentedBar, high) == offsetof(AugmentedBar, open) + 2 * sizeof(double));
+    static_assert(offsetof(AugmentedBar, highNormalized) == offsetof(AugmentedBar, open) + 3 * sizeof(double));
+    static_assert(offsetof(AugmentedBar, lowNormalized) == offsetof(AugmentedBar, low) + sizeof(double));
+    static_assert(offsetof(AugmentedBar, close) == offsetof(AugmentedBar, low) + 2 * sizeof(double));
+    static_assert(offsetof(AugmentedBar, closeNormalized) == offsetof(AugmentedBar, low) + 3 * sizeof(double));
+    static_assert(offsetof(AugmentedBar, averageNormalized) == offsetof(AugmentedBar, average) + sizeof(double));
+    static_assert(offsetof(AugmentedBar, volume) == offsetof(AugmentedBar, average) + 2 * sizeof(double));
+    static_assert(offsetof(AugmentedBar, volumeNormalized) == offsetof(AugmentedBar, average) + 3 * sizeof(double));
+    static_assert(offsetof(AugmentedBar, amountNormalized) == offsetof(AugmentedBar, amount) + sizeof(double));
+
+    __attribute__((target("avx2")))
+    void NormalizeAvx2(AugmentedBar* bars, size_t count)
+    {
+        const double doubleMax = std::numeric_limits<double>::max();
+        __m256d priceMaxes = _mm256_setzero_pd();          // lane 2: high
+        __m256d priceMins = _mm256_set1_pd(doubleMax);     // lane 0: low
+        __m256d volumeMaxes = _mm256_setzero_pd();         // lane 2: volume
+        __m256d volumeMins = _mm256_set1_pd(doubleMax);    // lane 2: volume
+        __m128d amountMaxes = _mm_setzero_pd();            // lane 0: amount
+        __m128d amountMins = _mm_set1_pd(doubleMax);       // lane 0: amount
+
+        for (size_t i = 0; i < count; ++i)
+        {
+            const AugmentedBar& bar = bars[i];
+            __m256d openHigh = _mm256_loadu_pd(&bar.open);
+            __m256d lowClose = _mm256_loadu_pd(&bar.low);
+            __m256d averageVolume = _mm256_loadu_pd(&bar.average);
+            __m128d amount = _mm_loadu_pd(&bar.amount);
+
+            // max(a, b) is a > b ? a : b, the same as the scalar if (value > max) max = value
+            priceMaxes = _mm256_max_pd(openHigh, priceMaxes);
+            priceMins = _mm256_min_pd(lowClose, priceMins);
+            volumeMaxes = _mm256_max_pd(averageVolume, volumeMaxes);
+            volumeMins = _mm256_min_pd(averageVolume, volumeMins);
+            amountMaxes = _mm_max_pd(amount, amountMaxes);
+            amountMins = _mm_min_pd(amount, amountMins);
+        }
+
+        double priceMax = _mm_cvtsd_f64(_mm256_extractf128_pd(priceMaxes, 1));
+        double priceMin = _mm256_cvtsd_f64(priceMins);
+        double volumeMax = _mm_cvtsd_f64(_mm256_extractf128_pd(volumeMaxes, 1));
+        double volumeMin = _mm_cvtsd_f64(_mm256_extractf128_pd(volumeMins, 1));
+        double amountMax = _mm_cvtsd_f64(amountMaxes);
+        double amountMin = _mm_cvtsd_f64(amountMins);
+
+        double priceRange = priceMax - priceMin;
+        double volumeRange = volumeMax - volumeMin;
+        double amountRange = amountMax - amountMin;
+
+        // odd lanes hold the old normalized values, they are computed against 0 / 1 and never stored
+        const __m256d priceOffsets = _mm256_setr_pd(priceMin, 0.0, priceMin, 0.0);
+        const __m256d priceRanges = _mm256_setr_pd(priceRange, 1.0, priceRange, 1.0);
+        const __m256d averageVolumeOffsets = _mm256_setr_pd(priceMin, 0.0, volumeMin, 0.0);
+        const __m256d averageVolumeRanges = _mm256_setr_pd(priceRange, 1.0, volumeRange, 1.0);
+        const __m128d amountOffsets = _mm_setr_pd(amountMin, 0.0);
+        const __m128d amountRanges = _mm_setr_pd(amountRange, 1.0);
+
+        // a zero range gives +0.0 instead of the division, != is unordered so a NaN range still divides
+        const __m256d priceMask = _mm256_cmp_pd(priceRanges, _mm256_setzero_pd(), _CMP_NEQ_UQ);
+        const __m256d averageVolumeMask = _mm256_cmp_pd(averageVolumeRanges, _mm256_setzero_pd(), _CMP_NEQ_UQ);
+        const __m128d amountMask = _mm_cmp_pd(amountRanges, _mm_setzero_pd(), _CMP_NEQ_UQ);
+        // only the normalized fields are written, the raw ones may be read by other threads meanwhile
+        const __m256i normalizedLanes = _mm256_setr_epi64x(0, -1, 0, -1);
+
+        for (size_t i = 0; i < count; ++i)
+        {
+            AugmentedBar& bar = bars[i];
+            __m256d openHigh = _mm256_loadu_pd(&bar.open);
+            __m256d lowClose = _mm256_loadu_pd(&bar.low);
+            __m256d averageVolume = _mm256_loadu_pd(&bar.average);
+            __m128d amount = _mm_loadu_pd(&bar.amount);
+
+            __m256d openHighNormalized = _mm256_and_pd(_mm256_div_pd(_mm256_sub_pd(openHigh, priceOffsets), priceRanges), priceMask);
+            __m256d lowCloseNormalized = _mm256_and_pd(_mm256_div_pd(_mm256_sub_pd(lowClose, priceOffsets), priceRanges), priceMask);
+            __m256d averageVolumeNormalized = _mm256_and_pd(_mm256_div_pd(_mm256_sub_pd(averageVolume, averageVolumeOffsets), averageVolumeRanges), averageVolumeMask);
+            __m128d amountNormalized = _mm_and_pd(_mm_div_pd(_mm_sub_pd(amount, amountOffsets), amountRanges), amountMask);
+
+            // movedup moves the result of each even lane to the odd lane of its normalized field
+            _mm256_maskstore_pd(&bar.open, normalizedLanes, _mm256_movedup_pd(openHighNormalized));
+            _mm256_maskstore_pd(&bar.low, normalizedLanes, _mm256_movedup_pd(lowCloseNormalized));
+            _mm256_maskstore_pd(&bar.average, normalizedLanes, _mm256_movedup_pd(averageVolumeNormalized));
+            _mm_store_sd(&bar.amountNormalized, amountNormalized);
+        }
+    }
+#endif
+
+    using NormalizeKernel = void (*)(AugmentedBar*, size_t);
+
+    NormalizeKernel SelectNormalizeKernel()
+    {
+#ifdef STOCKDATA_NORMALIZE_AVX2
+        if (__builtin_cpu_supports("avx2"))
+        {
+            return NormalizeAvx2;
+        }
+#endif
+        return NormalizeScalar;
+    }
+}
+
+void StockData::NormalizeBars(AugmentedBar *bars, size_t count)
+{
+    STOCKDATA_METRIC_SCOPE(Normalize);
+    static const NormalizeKernel kernel = SelectNormalizeKernel();
+    kernel(bars, count);
+}
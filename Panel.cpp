@@ -0,0 +1,265 @@
+#include "Panel.hpp"
+#include "Parallel.hpp"
+#include <algorithm>
+#include <cmath>
+#include <limits>
+
+namespace
+{
+    using StockData::Bar;
+    using StockData::Bars;
+    using StockData::Panel;
+    using StockData::PanelField;
+
+    constexpr size_t ROWS_PER_TASK = 64;
+    constexpr double MISSING = std::numeric_limits<double>::quiet_NaN();
+
+    void SetCell(Panel& panel, size_t row, size_t symbolIndex, const Bar& bar)
+    {
+        size_t cell = row * panel.symbols.size() + symbolIndex;
+        panel.values[static_cast<size_t>(PanelField::Open)][cell] = bar.open;
+        panel.values[static_cast<size_t>(PanelField::High)][cell] = bar.high;
+        panel.values[static_cast<size_t>(PanelField::Low)][cell] = bar.low;
+        panel.values[static_cast<size_t>(PanelField::Close)][cell] = bar.close;
+        panel.values[static_cast<size_t>(PanelField::Volume)][cell] = bar.volume;
+        panel.values[static_cast<size_t>(PanelField::Amount)][cell] = bar.amount;
+        panel.mask[cell] = 1;
+    }
+
+    void ResizeRows(Panel& panel, size_t rowCount)
+    {
+        size_t cells = rowCount * panel.symbols.size();
+        for (auto& field : panel.values)
+        {
+            field.resize(cells, MISSING);
+        }
+        panel.mask.resize(cells, 0);
+    }
+
+    /// @brief Fill rows [firstRow, DateCount()) from the bars, tasks own disjoint blocks of rows
+    void FillRows(const std::vector<const Bars*>& bars, size_t firstRow, size_t threads, Panel& panel)
+    {
+        size_t rowCount = panel.dates.size() - firstRow;
+        size_t taskCount = (rowCount + ROWS_PER_TASK - 1) / ROWS_PER_TASK;
+        StockData::ParallelFor(taskCount, threads, [&](size_t task)
+        {
+            size_t taskFirstRow = firstRow + task * ROWS_PER_TASK;
+            size_t taskEndRow = std::min(taskFirstRow + ROWS_PER_TASK, panel.dates.size());
+            for (size_t s = 0; s < bars.size(); ++s)
+            {
+                if (bars[s] == nullptr)
+                {
+                    continue;
+                }
+                const std::vector<Bar>& data = bars[s]->data;
+                auto it = std::lower_bound(data.begin(), data.end(), panel.dates[taskFirstRow],
+                    [](const Bar& bar, uint64_t date) { return bar.time < date; });
+                for (size_t row = taskFirstRow; row < taskEndRow && it != data.end(); ++row)
+                {
+                    // bars before the row are duplicates of a time already filled, skip them or the cursor never moves again
+                    while (it != data.end() && it->time < panel.dates[row])
+                    {
+                        ++it;
+                    }
+                    if (it != data.end() && it->time == panel.dates[row])
+                    {
+                        SetCell(panel, row, s, *it);
+                        ++it;
+                    }
+                }
+            }
+        });
+    }
+}
+
+bool StockData::Panel::FindDateIndex(uint64_t date, size_t &dateIndex) const
+{
+    auto it = std::lower_bound(dates.begin(), dates.end(), date);
+    if (it == dates.end() || *it != date)
+    {
+        return false;
+    }
+    dateIndex = it - dates.begin();
+    return true;
+}
+
+bool StockData::Panel::GetWindow(uint64_t date, size_t count, size_t &firstDateIndex, size_t &rowCount) const
+{
+    size_t dateIndex;
+    if (!FindDateIndex(date, dateIndex))
+    {
+        return false;
+    }
+    rowCount = std::min(count, dateIndex + 1);
+    firstDateIndex = dateIndex + 1 - rowCount;
+    return true;
+}
+
+bool StockData::Panel::AppendDate(uint64_t date, const std::vector<const Bar*> &bars)
+{
+    if ((!dates.empty() && date <= dates.back()) || bars.size() != symbols.size())
+    {
+        return false;
+    }
+
+    dates.push_back(date);
+    ResizeRows(*this, dates.size());
+    for (size_t s = 0; s < bars.size(); ++s)
+    {
+        if (bars[s] != nullptr)
+        {
+            SetCell(*this, dates.size() - 1, s, *bars[s]);
+        }
+    }
+    return true;
+}
+
+void StockData::Panel::Clear()
+{
+    symbols.clear();
+    dates.clear();
+    for (auto& field : values)
+    {
+        field.clear();
+    }
+    mask.clear();
+}
+
+bool StockData::BuildPanel(const std::vector<std::string> &symbols, const std::vector<const Bars*> &bars, size_t threads, Panel &panel)
+{
+    panel.Clear();
+    if (symbols.size() != bars.size())
+    {
+        return false;
+    }
+    panel.symbols = symbols;
+
+    for (const Bars* series : bars)
+    {
+        if (series != nullptr)
+        {
+            for (const Bar& bar : series->data)
+            {
+                panel.dates.push_back(bar.time);
+            }
+        }
+    }
+    std::sort(panel.dates.begin(), panel.dates.end());
+    panel.dates.erase(std::unique(panel.dates.begin(), panel.dates.end()), panel.dates.end());
+
+    ResizeRows(panel, panel.dates.size());
+    FillRows(bars, 0, threads, panel);
+    return true;
+}
+
+bool StockData::BuildPanel(const Universe &universe, size_t threads, Panel &panel)
+{
+    std::vector<const Bars*> bars(universe.bars.size());
+    for (size_t i = 0; i < bars.size(); ++i)
+    {
+        bars[i] = &universe.bars[i];
+    }
+    return BuildPanel(universe.symbols, bars, threads, panel);
+}
+
+size_t StockData::ExtendPanel(const std::vector<const Bars*> &bars, size_t threads, Panel &panel)
+{
+    if (bars.size() != panel.symbols.size())
+    {
+        return 0;
+    }
+
+    size_t firstRow = panel.dates.size();
+    uint64_t lastDate = panel.dates.empty() ? 0 : panel.dates.back();
+    for (const Bars* series : bars)
+    {
+        if (series == nullptr)
+        {
+            continue;
+        }
+        auto it = std::upper_bound(series->data.begin(), series->data.end(), lastDate,
+            [](uint64_t date, const Bar& bar) { return date < bar.time; });
+        for (; it != series->data.end(); ++it)
+        {
+            panel.dates.push_back(it->time);
+        }
+    }
+    std::sort(panel.dates.begin() + firstRow, panel.dates.end());
+    panel.dates.erase(std::unique(panel.dates.begin() + firstRow, panel.dates.end()), panel.dates.end());
+
+    ResizeRows(panel, panel.dates.size());
+    FillRows(bars, firstRow, threads, panel);
+    return panel.dates.size() - firstRow;
+}
+
+void StockData::CrossSectionalZScore(const Panel &panel, PanelField field, size_t dateIndex, double *output)
+{
+    const double* row = panel.Row(field, dateIndex);
+    const uint8_t* rowMask = panel.Mask(dateIndex);
+    const size_t symbolCount = panel.SymbolCount();
+
+    // NaN values are left out the same way as missing bars
+    auto present = [&](size_t s) { return rowMask[s] && !std::isnan(row[s]); };
+
+    double sum = 0.0;
+    size_t count = 0;
+    for (size_t s = 0; s < symbolCount; ++s)
+    {
+        sum += present(s) ? row[s] : 0.0;
+        count += present(s);
+    }
+    double mean = count > 0 ? sum / count : 0.0;
+
+    double squares = 0.0;
+    for (size_t s = 0; s < symbolCount; ++s)
+    {
+        double deviation = present(s) ? row[s] - mean : 0.0;
+        squares += deviation * deviation;
+    }
+    double deviation = count > 0 ? std::sqrt(squares / count) : 0.0;
+    double scale = deviation > 0.0 ? 1.0 / deviation : 0.0;
+
+    for (size_t s = 0; s < symbolCount; ++s)
+    {
+        output[s] = present(s) ? (row[s] - mean) * scale : MISSING;
+    }
+}
+
+void StockData::CrossSectionalRank(const Panel &panel, PanelField field, size_t dateIndex, double *output)
+{
+    const double* row = panel.Row(field, dateIndex);
+    const uint8_t* rowMask = panel.Mask(dateIndex);
+    const size_t symbolCount = panel.SymbolCount();
+
+    std::vector<size_t> order;
+    order.reserve(symbolCount);
+    for (size_t s = 0; s < symbolCount; ++s)
+    {
+        output[s] = MISSING;
+        if (rowMask[s] && !std::isnan(row[s])) // NaN values are left out the same way as missing bars
+        {
+            order.push_back(s);
+        }
+    }
+    if (order.empty())
+    {
+        return;
+    }
+    std::sort(order.begin(), order.end(), [&](size_t a, size_t b) { return row[a] < row[b]; });
+
+    double scale = order.size() > 1 ? 1.0 / (order.size() - 1) : 0.0;
+    for (size_t first = 0; first < order.size();)
+    {
+        size_t end = first + 1;
+        while (end < order.size() && row[order[end]] == row[order[first]])
+        {
+            ++end;
+        }
+        double rank = order.size() > 1 ? 0.5 * (first + end - 1) * scale : 0.5;
+        for (size_t i = first; i < end; ++i)
+        {
+            output[order[i]] = rank;
+        }
+        first = end;
+    }
+}
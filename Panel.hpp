@@ -0,0 +1,89 @@
+#pragma once
+#include <cstddef>
+#include <cstdint>
+#include <string>
+#include <vector>
+
+#include "StockData.hpp"
+#include "Universe.hpp"
+
+namespace StockData
+{
+    enum class PanelField
+    {
+        Open = 0,
+        High,
+        Low,
+        Close,
+        Volume,
+        Amount,
+        Count
+    };
+
+    /// @brief Bars of many symbols transposed into date-major matrices: one row per date, one column per symbol.
+    /// Each row of a field is contiguous, so cross-sectional operations run over plain arrays.
+    /// Symbols without a bar on a date (suspended, not listed yet) are NaN and 0 in the mask
+    struct Panel
+    {
+        static constexpr size_t FIELD_COUNT = static_cast<size_t>(PanelField::Count);
+
+        std::vector<std::string> symbols;
+        std::vector<uint64_t> dates; // ascending
+        std::vector<double> values[FIELD_COUNT];
+        std::vector<uint8_t> mask;   // 1 where the symbol has a bar on the date
+
+        size_t SymbolCount() const { return symbols.size(); }
+        size_t DateCount() const { return dates.size(); }
+
+        /// @brief Values of a field on a date, one per symbol
+        const double* Row(PanelField field, size_t dateIndex) const { return values[static_cast<size_t>(field)].data() + dateIndex * symbols.size(); }
+        double* Row(PanelField field, size_t dateIndex) { return values[static_cast<size_t>(field)].data() + dateIndex * symbols.size(); }
+
+        /// @brief Mask of a date, one per symbol
+        const uint8_t* Mask(size_t dateIndex) const { return mask.data() + dateIndex * symbols.size(); }
+
+        /// @brief Row of a date, by binary search
+        /// @return true if found, false otherwise
+        bool FindDateIndex(uint64_t date, size_t& dateIndex) const;
+
+        /// @brief Rows of count dates ending at the given date (included). The rows are contiguous,
+        /// so Row(field, firstDateIndex) is a rowCount x SymbolCount() matrix
+        /// @param date last date of the window
+        /// @param count number of dates, fewer are returned when the panel starts later
+        /// @return true if the date was found, false otherwise
+        bool GetWindow(uint64_t date, size_t count, size_t& firstDateIndex, size_t& rowCount) const;
+
+        /// @brief Append one date
+        /// @param date must be after the last date of the panel
+        /// @param bars one per symbol, nullptr where the symbol has no bar
+        /// @return false if the date is not after the last date or the number of bars does not match
+        bool AppendDate(uint64_t date, const std::vector<const Bar*>& bars);
+
+        void Clear();
+    };
+
+    /// @brief Build a panel over the union of the dates of the given bars, on a pool of worker threads
+    /// @param symbols one per series
+    /// @param bars daily bars of each symbol, sorted by date. Of several bars with the same date, the first one is used
+    /// @param threads number of worker threads, 0 for one per hardware thread
+    /// @param panel the result, gets cleared in this function
+    /// @return false if the number of bars does not match the number of symbols, the panel is left empty
+    bool BuildPanel(const std::vector<std::string>& symbols, const std::vector<const Bars*>& bars, size_t threads, Panel& panel);
+
+    /// @brief Build a panel of the bars of a universe, see BuildPanel
+    bool BuildPanel(const Universe& universe, size_t threads, Panel& panel);
+
+    /// @brief Append the dates of the given bars that are after the last date of the panel
+    /// @param bars one per symbol of the panel, in the same order
+    /// @param threads number of worker threads, 0 for one per hardware thread
+    /// @return the number of dates appended
+    size_t ExtendPanel(const std::vector<const Bars*>& bars, size_t threads, Panel& panel);
+
+    /// @brief Cross-sectional z-score of a field on a date, over the symbols that have a bar
+    /// @param output one per symbol, NaN where the symbol has no bar, 0 if all values are equal
+    void CrossSectionalZScore(const Panel& panel, PanelField field, size_t dateIndex, double* output);
+
+    /// @brief Cross-sectional rank of a field on a date, scaled to [0, 1], ties get their average rank
+    /// @param output one per symbol, NaN where the symbol has no bar, 0.5 if only one symbol has a bar
+    void CrossSectionalRank(const Panel& panel, PanelField field, size_t dateIndex, double* output);
+}
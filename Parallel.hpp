@@ -0,0 +1,61 @@
+#pragma once
+#include <algorithm>
+#include <atomic>
+#include <cstddef>
+#include <thread>
+#include <vector>
+
+namespace StockData
+{
+    /// @brief Number of worker threads to use when the caller passes 0
+    inline size_t DefaultThreadCount()
+    {
+        size_t hardwareThreads = std::thread::hardware_concurrency();
+        return hardwareThreads > 0 ? hardwareThreads : 1;
+    }
+
+    /// @brief Run function(i) for every i in [0, count) on a pool of worker threads.
+    /// Work items are handed out one at a time, so at most `threads` of them run at once
+    /// @param count number of work items
+    /// @param threads number of worker threads, 0 for one per hardware thread
+    /// @param function called as function(index), must not throw
+    template <typename Function>
+    void ParallelFor(size_t count, size_t threads, Function&& function)
+    {
+        if (threads == 0)
+        {
+            threads = DefaultThreadCount();
+        }
+        threads = std::min(threads, count);
+
+        if (threads <= 1)
+        {
+            for (size_t i = 0; i < count; ++i)
+            {
+                function(i);
+            }
+            return;
+        }
+
+        std::atomic<size_t> next{0};
+        auto worker = [&]()
+        {
+            for (size_t i = next.fetch_add(1, std::memory_order_relaxed); i < count; i = next.fetch_add(1, std::memory_order_relaxed))
+            {
+                function(i);
+            }
+        };
+
+        std::vector<std::thread> workers;
+        workers.reserve(threads - 1);
+        for (size_t i = 1; i < threads; ++i)
+        {
+            workers.emplace_back(worker);
+        }
+        worker();
+        for (auto& thread : workers)
+        {
+            thread.join();
+        }
+    }
+}
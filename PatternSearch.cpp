@@ -0,0 +1,418 @@
+#include "PatternSearch.hpp"
+#include "Indicators.hpp"
+#include "Parallel.hpp"
+#include <algorithm>
+#include <cmath>
+#include <limits>
+
+#if defined(__x86_64__) || defined(__i386__)
+#include <immintrin.h>
+#define STOCKDATA_PATTERN_AVX2 1
+#endif
+
+namespace
+{
+    using StockData::AugmentedBar;
+    using StockData::AugmentedBars;
+    using StockData::PatternIndex;
+    using StockData::PatternMatch;
+    using StockData::PatternSearchOptions;
+    using StockData::PATTERN_FEATURE_COUNT;
+
+    constexpr size_t PRICE_FEATURE_COUNT = 5; // open, high, low, close, average share the price range
+    constexpr size_t VOLUME_FEATURE = 5;
+    constexpr size_t ABANDON_BLOCK = 16;      // bars summed between two early-abandon checks
+    constexpr double INFINITE_DISTANCE = std::numeric_limits<double>::infinity();
+
+    using FeatureColumns = std::array<std::vector<double>, PATTERN_FEATURE_COUNT>;
+
+    /// @brief Sum over i of ((x[i] - low) * scale - q[i])^2
+    double SquaredDistanceScalar(const double* x, const double* q, size_t count, double low, double scale)
+    {
+        double sum = 0.0;
+        for (size_t i = 0; i < count; ++i)
+        {
+            double difference = (x[i] - low) * scale - q[i];
+            sum += difference * difference;
+        }
+        return sum;
+    }
+
+#ifdef STOCKDATA_PATTERN_AVX2
+    __attribute__((target("avx2")))
+    double SquaredDistanceAvx2(const double* x, const double* q, size_t count, double low, double scale)
+    {
+        const __m256d lowVector = _mm256_set1_pd(low);
+        const __m256d scaleVector = _mm256_set1_pd(scale);
+        __m256d sumVector = _mm256_setzero_pd();
+        size_t i = 0;
+        for (; i + 4 <= count; i += 4)
+        {
+            __m256d normalized = _mm256_mul_pd(_mm256_sub_pd(_mm256_loadu_pd(x + i), lowVector), scaleVector);
+            __m256d difference = _mm256_sub_pd(normalized, _mm256_loadu_pd(q + i));
+            sumVector = _mm256_add_pd(sumVector, _mm256_mul_pd(difference, difference));
+        }
+        __m128d pair = _mm_add_pd(_mm256_castpd256_pd128(sumVector), _mm256_extractf128_pd(sumVector, 1));
+        double sum = _mm_cvtsd_f64(_mm_add_sd(pair, _mm_unpackhi_pd(pair, pair)));
+        return sum + SquaredDistanceScalar(x + i, q + i, count - i, low, scale);
+    }
+#endif
+
+    using DistanceKernel = double (*)(const double*, const double*, size_t, double, double);
+
+    DistanceKernel SelectDistanceKernel()
+    {
+#ifdef STOCKDATA_PATTERN_AVX2
+        if (__builtin_cpu_supports("avx2"))
+        {
+            return SquaredDistanceAvx2;
+        }
+#endif
+        return SquaredDistanceScalar;
+    }
+
+    /// @brief Offset and scale that min-max normalize one window, see NormalizeBars
+    struct WindowScale
+    {
+        double priceLow;
+        double priceScale;
+        double volumeLow;
+        double volumeScale;
+
+        double Low(size_t feature) const { return feature < PRICE_FEATURE_COUNT ? priceLow : volumeLow; }
+        double Scale(size_t feature) const { return feature < PRICE_FEATURE_COUNT ? priceScale : volumeScale; }
+    };
+
+    /// @brief Scales of every window of a series, scales[s] is for the window starting at bar s
+    void ComputeWindowScales(const FeatureColumns& columns, size_t count, std::vector<WindowScale>& scales)
+    {
+        const size_t barCount = columns[0].size();
+        scales.resize(barCount - count + 1);
+        StockData::RollingMinMax lows(count), highs(count), volumes(count);
+        for (size_t i = 0; i < barCount; ++i)
+        {
+            lows.Push(columns[2][i]);
+            highs.Push(columns[1][i]);
+            volumes.Push(columns[VOLUME_FEATURE][i]);
+            if (i + 1 >= count)
+            {
+                double priceRange = highs.Max() - lows.Min();
+                double volumeRange = volumes.Max() - volumes.Min();
+                scales[i + 1 - count] = WindowScale{
+                    lows.Min(), priceRange != 0.0 ? 1.0 / priceRange : 0.0,
+                    volumes.Min(), volumeRange != 0.0 ? 1.0 / volumeRange : 0.0};
+            }
+        }
+    }
+
+    void GetQueryColumns(const AugmentedBar* query, size_t count, FeatureColumns& columns)
+    {
+        for (auto& column : columns)
+        {
+            column.resize(count);
+        }
+        for (size_t i = 0; i < count; ++i)
+        {
+            columns[0][i] = query[i].openNormalized;
+            columns[1][i] = query[i].highNormalized;
+            columns[2][i] = query[i].lowNormalized;
+            columns[3][i] = query[i].closeNormalized;
+            columns[4][i] = query[i].averageNormalized;
+            columns[5][i] = query[i].volumeNormalized;
+        }
+    }
+
+    /// @brief Upper and lower envelope of the query over the warping window, for LB_Keogh.
+    /// Computed once per search, so the O(count * warpingWindow) loop does not matter
+    void GetQueryEnvelope(const FeatureColumns& query, size_t warpingWindow, FeatureColumns& upper, FeatureColumns& lower)
+    {
+        const size_t count = query[0].size();
+        for (size_t f = 0; f < PATTERN_FEATURE_COUNT; ++f)
+        {
+            upper[f].resize(count);
+            lower[f].resize(count);
+            for (size_t i = 0; i < count; ++i)
+            {
+                size_t first = i > warpingWindow ? i - warpingWindow : 0;
+                size_t last = std::min(count - 1, i + warpingWindow);
+                auto [low, high] = std::minmax_element(query[f].begin() + first, query[f].begin() + last + 1);
+                lower[f][i] = *low;
+                upper[f][i] = *high;
+            }
+        }
+    }
+
+    /// @brief Best matches of one series, sorted by distance, at most k of them
+    struct MatchList
+    {
+        size_t k;
+        bool excludeOverlaps;
+        size_t windowSize;
+        std::vector<PatternMatch> matches;
+
+        /// @brief Squared distance a window has to beat to enter the list
+        double Threshold() const
+        {
+            return matches.size() < k ? INFINITE_DISTANCE : matches.back().distance;
+        }
+
+        void Add(const PatternMatch& match)
+        {
+            if (excludeOverlaps)
+            {
+                for (auto it = matches.begin(); it != matches.end();)
+                {
+                    bool overlaps = it->firstBar < match.firstBar + windowSize && match.firstBar < it->firstBar + windowSize;
+                    if (!overlaps)
+                    {
+                        ++it;
+                    }
+                    else if (it->distance <= match.distance)
+                    {
+                        return;
+                    }
+                    else
+                    {
+                        it = matches.erase(it);
+                    }
+                }
+            }
+            auto position = std::upper_bound(matches.begin(), matches.end(), match.distance,
+                [](double distance, const PatternMatch& other) { return distance < other.distance; });
+            matches.insert(position, match);
+            if (matches.size() > k)
+            {
+                matches.pop_back();
+            }
+        }
+    };
+
+    double EuclideanDistance(DistanceKernel kernel, const FeatureColumns& columns, size_t first, const FeatureColumns& query, const WindowScale& scale, double threshold)
+    {
+        const size_t count = query[0].size();
+        double sum = 0.0;
+        for (size_t block = 0; block < count; block += ABANDON_BLOCK)
+        {
+            size_t blockSize = std::min(ABANDON_BLOCK, count - block);
+            for (size_t f = 0; f < PATTERN_FEATURE_COUNT; ++f)
+            {
+                sum += kernel(columns[f].data() + first + block, query[f].data() + block, blockSize, scale.Low(f), scale.Scale(f));
+            }
+            if (!(sum < threshold))
+            {
+                return INFINITE_DISTANCE;
+            }
+        }
+        return sum;
+    }
+
+    /// @brief LB_Keogh of a window, which also leaves the normalized window in `window`
+    double KeoghBound(const FeatureColumns& columns, size_t first, const FeatureColumns& upper, const FeatureColumns& lower, const WindowScale& scale, double threshold, FeatureColumns& window)
+    {
+        const size_t count = upper[0].size();
+        double sum = 0.0;
+        for (size_t f = 0; f < PATTERN_FEATURE_COUNT; ++f)
+        {
+            const double* x = columns[f].data() + first;
+            double low = scale.Low(f), factor = scale.Scale(f);
+            for (size_t i = 0; i < count; ++i)
+            {
+                double value = (x[i] - low) * factor;
+                window[f][i] = value;
+                double excess = value > upper[f][i] ? value - upper[f][i] : value < lower[f][i] ? lower[f][i] - value : 0.0;
+                sum += excess * excess;
+            }
+            if (!(sum < threshold))
+            {
+                return INFINITE_DISTANCE;
+            }
+        }
+        return sum;
+    }
+
+    double DtwDistance(const FeatureColumns& window, const FeatureColumns& query, size_t warpingWindow, double threshold, std::vector<double>& previous, std::vector<double>& current)
+    {
+        const size_t count = query[0].size();
+        previous.assign(count + 1, INFINITE_DISTANCE);
+        current.assign(count + 1, INFINITE_DISTANCE);
+        previous[0] = 0.0;
+        for (size_t i = 1; i <= count; ++i)
+        {
+            std::fill(current.begin(), current.end(), INFINITE_DISTANCE);
+            size_t firstJ = i > warpingWindow ? i - warpingWindow : 1;
+            size_t lastJ = std::min(count, i + warpingWindow);
+            double rowMinimum = INFINITE_DISTANCE;
+            for (size_t j = firstJ; j <= lastJ; ++j)
+            {
+                double cost = 0.0;
+                for (size_t f = 0; f < PATTERN_FEATURE_COUNT; ++f)
+                {
+                    double difference = window[f][i - 1] - query[f][j - 1];
+                    cost += difference * difference;
+                }
+                current[j] = cost + std::min({previous[j - 1], previous[j], current[j - 1]});
+                rowMinimum = std::min(rowMinimum, current[j]);
+            }
+            if (!(rowMinimum < threshold))
+            {
+                return INFINITE_DISTANCE;
+            }
+            std::swap(previous, current);
+        }
+        return previous[count];
+    }
+
+    void SearchSeries(const PatternIndex& index, size_t seriesIndex, const FeatureColumns& query, const FeatureColumns& upper, const FeatureColumns& lower,
+                      const PatternSearchOptions& options, std::vector<PatternMatch>& matches)
+    {
+        static const DistanceKernel kernel = SelectDistanceKernel();
+
+        const FeatureColumns& columns = index.columns[seriesIndex];
+        const size_t count = query[0].size();
+        if (columns[0].size() < count)
+        {
+            return;
+        }
+
+        std::vector<WindowScale> scales;
+        ComputeWindowScales(columns, count, scales);
+
+        MatchList list{options.k, options.excludeOverlaps, count, {}};
+        FeatureColumns window;
+        for (auto& column : window)
+        {
+            column.resize(count);
+        }
+        std::vector<double> previous, current;
+
+        const auto& bars = index.series[seriesIndex]->data;
+        for (size_t first = 0; first < scales.size(); ++first)
+        {
+            double threshold = list.Threshold();
+            double distance;
+            if (options.distance == StockData::PatternDistance::Dtw)
+            {
+                distance = KeoghBound(columns, first, upper, lower, scales[first], threshold, window);
+                if (distance < threshold)
+                {
+                    distance = DtwDistance(window, query, options.warpingWindow, threshold, previous, current);
+                }
+            }
+            else
+            {
+                distance = EuclideanDistance(kernel, columns, first, query, scales[first], threshold);
+            }
+
+            if (distance < threshold)
+            {
+                list.Add(PatternMatch{seriesIndex, first, bars[first + count - 1].time, distance});
+            }
+        }
+        matches = std::move(list.matches);
+    }
+}
+
+void StockData::PatternIndex::Build(const std::vector<const AugmentedBars*> &bars, size_t threads)
+{
+    series = bars;
+    columns.assign(bars.size(), {});
+    ParallelFor(bars.size(), threads, [&](size_t s)
+    {
+        const std::vector<AugmentedBar>& data = bars[s]->data;
+        FeatureColumns& seriesColumns = columns[s];
+        for (auto& column : seriesColumns)
+        {
+            column.resize(data.size());
+        }
+        for (size_t i = 0; i < data.size(); ++i)
+        {
+            seriesColumns[0][i] = data[i].open;
+            seriesColumns[1][i] = data[i].high;
+            seriesColumns[2][i] = data[i].low;
+            seriesColumns[3][i] = data[i].close;
+            seriesColumns[4][i] = data[i].average;
+            seriesColumns[5][i] = data[i].volume;
+        }
+    });
+}
+
+void StockData::PatternIndex::Build(const std::vector<AugmentedBars> &bars, size_t threads)
+{
+    std::vector<const AugmentedBars*> pointers(bars.size());
+    for (size_t i = 0; i < bars.size(); ++i)
+    {
+        pointers[i] = &bars[i];
+    }
+    Build(pointers, threads);
+}
+
+void StockData::FindSimilarPatterns(const PatternIndex &index, const AugmentedBar *query, size_t count, const PatternSearchOptions &options, size_t threads, std::vector<PatternMatch> &matches)
+{
+    matches.clear();
+    if (count == 0 || options.k == 0)
+    {
+        return;
+    }
+
+    FeatureColumns queryColumns, upper, lower;
+    GetQueryColumns(query, count, queryColumns);
+    if (options.distance == PatternDistance::Dtw)
+    {
+        GetQueryEnvelope(queryColumns, options.warpingWindow, upper, lower);
+    }
+
+    std::vector<std::vector<PatternMatch>> seriesMatches(index.SeriesCount());
+    ParallelFor(index.SeriesCount(), threads, [&](size_t s)
+    {
+        SearchSeries(index, s, queryColumns, upper, lower, options, seriesMatches[s]);
+    });
+
+    // every series keeps its own top k, so the overall top k is among them
+    for (auto& list : seriesMatches)
+    {
+        matches.insert(matches.end(), list.begin(), list.end());
+    }
+    std::sort(matches.begin(), matches.end(), [](const PatternMatch& a, const PatternMatch& b)
+    {
+        return a.distance != b.distance ? a.distance < b.distance : a.seriesIndex != b.seriesIndex ? a.seriesIndex < b.seriesIndex : a.firstBar < b.firstBar;
+    });
+    if (matches.size() > options.k)
+    {
+        matches.resize(options.k);
+    }
+    for (PatternMatch& match : matches)
+    {
+        match.distance = std::sqrt(match.distance);
+    }
+}
+
+void StockData::ExtractMatch(const PatternIndex &index, const PatternMatch &match, const AugmentedBar *query, size_t count, AugmentedBars &window)
+{
+    const AugmentedBars& series = *index.series[match.seriesIndex];
+    window.symbol = series.symbol;
+    window.frequency = series.frequency;
+    window.data.assign(series.data.begin() + match.firstBar, series.data.begin() + match.firstBar + count);
+    window.Normalize();
+
+    double totalDistance = 0.0;
+    for (size_t i = 0; i < count; ++i)
+    {
+        AugmentedBar& bar = window.data[i];
+        double differences[PATTERN_FEATURE_COUNT] = {
+            bar.openNormalized - query[i].openNormalized,
+            bar.highNormalized - query[i].highNormalized,
+            bar.lowNormalized - query[i].lowNormalized,
+            bar.closeNormalized - query[i].closeNormalized,
+            bar.averageNormalized - query[i].averageNormalized,
+            bar.volumeNormalized - query[i].volumeNormalized};
+        double sum = 0.0;
+        for (double difference : differences)
+        {
+            sum += difference * difference;
+        }
+        bar.barDistance = std::sqrt(sum);
+        bar.HasDistances = 1;
+        totalDistance += bar.barDistance;
+    }
+    window.averageDistance = count > 0 ? totalDistance / count : 0.0;
+}
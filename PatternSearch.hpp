@@ -0,0 +1,64 @@
+#pragma once
+#include <array>
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+
+#include "StockData.hpp"
+
+namespace StockData
+{
+    // Bars are compared on open, high, low, close, average and volume, min-max normalized
+    // over each window the same way as NormalizeBars (amount follows volume too closely to add anything)
+    constexpr size_t PATTERN_FEATURE_COUNT = 6;
+
+    enum class PatternDistance
+    {
+        Euclidean = 0,
+        Dtw // dynamic time warping within a Sakoe-Chiba band, pruned with LB_Keogh
+    };
+
+    struct PatternSearchOptions
+    {
+        size_t k = 10;
+        PatternDistance distance = PatternDistance::Euclidean;
+        size_t warpingWindow = 0;    // band half-width in bars for Dtw
+        bool excludeOverlaps = true; // of two overlapping windows of the same series, keep only the closer one
+    };
+
+    struct PatternMatch
+    {
+        size_t seriesIndex; // index of the series in the PatternIndex
+        size_t firstBar;    // index of the first bar of the window in the series
+        uint64_t time;      // time of the last bar of the window
+        double distance;
+    };
+
+    /// @brief Raw bar values of many series transposed into one column per feature, so that
+    /// distances over consecutive bars run over contiguous memory
+    struct PatternIndex
+    {
+        std::vector<const AugmentedBars*> series; // not owned, must outlive the index
+        std::vector<std::array<std::vector<double>, PATTERN_FEATURE_COUNT>> columns;
+
+        size_t SeriesCount() const { return series.size(); }
+
+        /// @param threads number of worker threads, 0 for one per hardware thread
+        void Build(const std::vector<const AugmentedBars*>& bars, size_t threads = 0);
+        void Build(const std::vector<AugmentedBars>& bars, size_t threads = 0);
+    };
+
+    /// @brief Find the k windows most similar to a query across all the series of an index,
+    /// one task per series on a pool of worker threads
+    /// @param query normalized bars (see NormalizeBars), only the *Normalized fields are read
+    /// @param count number of bars of the query, and of every window compared against it
+    /// @param threads number of worker threads, 0 for one per hardware thread
+    /// @param matches the results sorted by distance, closest first, gets cleared in this function
+    void FindSimilarPatterns(const PatternIndex& index, const AugmentedBar* query, size_t count, const PatternSearchOptions& options, size_t threads, std::vector<PatternMatch>& matches);
+
+    /// @brief Copy the window of a match, normalized, with the distance of each bar to the query bar
+    /// at the same position in barDistance (HasDistances set), and their mean in averageDistance
+    /// @param query the query the match was found for
+    /// @param count number of bars of the query
+    void ExtractMatch(const PatternIndex& index, const PatternMatch& match, const AugmentedBar* query, size_t count, AugmentedBars& window);
+}
@@ -0,0 +1,269 @@
+#include "SampleGenerator.hpp"
+#include "Parallel.hpp"
+#include <algorithm>
+#include <cstring>
+#include <numeric>
+#include <random>
+#include <unordered_map>
+
+namespace
+{
+    using StockData::AugmentedBar;
+    using StockData::SampleFeature;
+
+    constexpr size_t SAMPLES_PER_TASK = 16;
+
+    double GetNormalizedFeature(const AugmentedBar& bar, SampleFeature feature)
+    {
+        switch (feature)
+        {
+            case SampleFeature::Open: return bar.openNormalized;
+            case SampleFeature::High: return bar.highNormalized;
+            case SampleFeature::Low: return bar.lowNormalized;
+            case SampleFeature::Close: return bar.closeNormalized;
+            case SampleFeature::Average: return bar.averageNormalized;
+            case SampleFeature::Volume: return bar.volumeNormalized;
+            case SampleFeature::Amount: return bar.amountNormalized;
+        }
+        return 0.0;
+    }
+}
+
+template <typename T>
+StockData::SampleGenerator<T>::SampleGenerator(const std::vector<std::string> &symbols, const std::vector<const AugmentedBars*> &series,
+                                               const std::vector<SampleAnchor> &anchors, const SampleGeneratorOptions &generatorOptions)
+    : options(generatorOptions)
+{
+    options.batchSize = std::max<size_t>(options.batchSize, 1);
+
+    std::unordered_map<std::string, size_t> symbolIndices;
+    for (size_t i = 0; i < symbols.size(); ++i)
+    {
+        symbolIndices.emplace(symbols[i], i);
+    }
+
+    samples.reserve(anchors.size());
+    for (size_t i = 0; i < anchors.size(); ++i)
+    {
+        auto it = symbolIndices.find(anchors[i].symbol);
+        size_t lastBar;
+        if (it == symbolIndices.end() || series[it->second] == nullptr
+            || !series[it->second]->FindDateIndex(anchors[i].date, lastBar) || lastBar + 1 < options.window)
+        {
+            droppedAnchors.push_back(i);
+            continue;
+        }
+        samples.push_back(Sample{i, series[it->second]->data.data() + lastBar + 1 - options.window});
+    }
+
+    for (Slot& slot : slots)
+    {
+        slot.values.resize(options.batchSize * SampleSize());
+        slot.anchorIndices.resize(options.batchSize);
+    }
+
+    // the producer takes tasks too, so it counts as one of the threads
+    size_t threadCount = options.threads > 0 ? options.threads : DefaultThreadCount();
+    threadCount = std::clamp<size_t>(threadCount, 1, (options.batchSize + SAMPLES_PER_TASK - 1) / SAMPLES_PER_TASK);
+    windows.assign(threadCount, std::vector<AugmentedBar>(options.window));
+    for (size_t i = 1; i < threadCount; ++i)
+    {
+        workers.emplace_back(&SampleGenerator::RunWorker, this, i);
+    }
+}
+
+template <typename T>
+StockData::SampleGenerator<T>::~SampleGenerator()
+{
+    StopProducer();
+    {
+        std::lock_guard<std::mutex> lock(workerMutex);
+        workersStopping = true;
+    }
+    workerCondition.notify_all();
+    for (std::thread& worker : workers)
+    {
+        worker.join();
+    }
+}
+
+template <typename T>
+void StockData::SampleGenerator<T>::StartEpoch(uint64_t epoch)
+{
+    StopProducer();
+
+    order.resize(samples.size());
+    std::iota(order.begin(), order.end(), 0);
+    if (options.shuffle)
+    {
+        std::mt19937_64 random(options.seed ^ (epoch * 0x9e3779b97f4a7c15ULL));
+        std::shuffle(order.begin(), order.end(), random);
+    }
+
+    nextToFill = 0;
+    nextToTake = 0;
+    stopping = false;
+    for (Slot& slot : slots)
+    {
+        slot.ready = false;
+    }
+    producer = std::thread(&SampleGenerator::Produce, this);
+}
+
+template <typename T>
+size_t StockData::SampleGenerator<T>::NextBatch(T *output, std::vector<size_t> *anchorIndices)
+{
+    std::unique_lock<std::mutex> lock(mutex);
+    if (!producer.joinable() || nextToTake >= BatchCount())
+    {
+        return 0;
+    }
+
+    Slot& slot = slots[nextToTake % 2];
+    condition.wait(lock, [&] { return slot.ready; });
+
+    // the producer does not touch a ready slot, so it can be copied without the lock
+    lock.unlock();
+    memcpy(output, slot.values.data(), slot.sampleCount * SampleSize() * sizeof(T));
+    if (anchorIndices != nullptr)
+    {
+        anchorIndices->assign(slot.anchorIndices.begin(), slot.anchorIndices.begin() + slot.sampleCount);
+    }
+    size_t sampleCount = slot.sampleCount;
+
+    lock.lock();
+    slot.ready = false;
+    ++nextToTake;
+    lock.unlock();
+    condition.notify_all();
+    return sampleCount;
+}
+
+template <typename T>
+void StockData::SampleGenerator<T>::Produce()
+{
+    const size_t batchCount = BatchCount();
+    for (;;)
+    {
+        std::unique_lock<std::mutex> lock(mutex);
+        if (nextToFill >= batchCount)
+        {
+            return;
+        }
+        Slot& slot = slots[nextToFill % 2];
+        condition.wait(lock, [&] { return stopping || !slot.ready; });
+        if (stopping)
+        {
+            return;
+        }
+        size_t batch = nextToFill;
+        lock.unlock();
+
+        FillSlot(batch, slot);
+
+        lock.lock();
+        slot.ready = true;
+        ++nextToFill;
+        lock.unlock();
+        condition.notify_all();
+    }
+}
+
+template <typename T>
+void StockData::SampleGenerator<T>::FillSlot(size_t batch, Slot &slot)
+{
+    const size_t first = batch * options.batchSize;
+    const size_t sampleCount = std::min(options.batchSize, samples.size() - first);
+    {
+        std::lock_guard<std::mutex> lock(workerMutex);
+        taskSlot = &slot;
+        taskFirst = first;
+        taskSampleCount = sampleCount;
+        taskCount = (sampleCount + SAMPLES_PER_TASK - 1) / SAMPLES_PER_TASK;
+        nextTask.store(0, std::memory_order_relaxed);
+        busyWorkers = workers.size();
+        ++taskGeneration;
+    }
+    workerCondition.notify_all();
+
+    RunTasks(windows[0]);
+
+    // the workers may still be filling the tasks they took
+    std::unique_lock<std::mutex> lock(workerMutex);
+    workerCondition.wait(lock, [&] { return busyWorkers == 0; });
+    slot.sampleCount = sampleCount;
+}
+
+template <typename T>
+void StockData::SampleGenerator<T>::RunTasks(std::vector<AugmentedBar> &window)
+{
+    const size_t sampleSize = SampleSize();
+    for (size_t task = nextTask.fetch_add(1, std::memory_order_relaxed); task < taskCount; task = nextTask.fetch_add(1, std::memory_order_relaxed))
+    {
+        size_t taskEnd = std::min(taskSampleCount, (task + 1) * SAMPLES_PER_TASK);
+        for (size_t i = task * SAMPLES_PER_TASK; i < taskEnd; ++i)
+        {
+            const Sample& sample = samples[order[taskFirst + i]];
+            std::copy(sample.firstBar, sample.firstBar + options.window, window.begin());
+            NormalizeBars(window.data(), window.size());
+
+            T* values = taskSlot->values.data() + i * sampleSize;
+            for (const AugmentedBar& bar : window)
+            {
+                for (SampleFeature feature : options.features)
+                {
+                    *values++ = static_cast<T>(GetNormalizedFeature(bar, feature));
+                }
+            }
+            taskSlot->anchorIndices[i] = sample.anchorIndex;
+        }
+    }
+}
+
+template <typename T>
+void StockData::SampleGenerator<T>::RunWorker(size_t workerIndex)
+{
+    uint64_t seenGeneration = 0;
+    for (;;)
+    {
+        {
+            std::unique_lock<std::mutex> lock(workerMutex);
+            workerCondition.wait(lock, [&] { return workersStopping || taskGeneration != seenGeneration; });
+            if (workersStopping)
+            {
+                return;
+            }
+            seenGeneration = taskGeneration;
+        }
+
+        RunTasks(windows[workerIndex]);
+
+        bool last;
+        {
+            std::lock_guard<std::mutex> lock(workerMutex);
+            last = --busyWorkers == 0;
+        }
+        if (last)
+        {
+            workerCondition.notify_all();
+        }
+    }
+}
+
+template <typename T>
+void StockData::SampleGenerator<T>::StopProducer()
+{
+    if (!producer.joinable())
+    {
+        return;
+    }
+    {
+        std::lock_guard<std::mutex> lock(mutex);
+        stopping = true;
+    }
+    condition.notify_all();
+    producer.join();
+}
+
+template struct StockData::SampleGenerator<float>;
+template struct StockData::SampleGenerator<double>;
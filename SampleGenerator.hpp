@@ -0,0 +1,134 @@
+#pragma once
+#include <atomic>
+#include <condition_variable>
+#include <cstddef>
+#include <cstdint>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <vector>
+
+#include "StockData.hpp"
+
+namespace StockData
+{
+    /// @brief Normalized field of AugmentedBar written for each bar of a sample
+    enum class SampleFeature
+    {
+        Open = 0,
+        High,
+        Low,
+        Close,
+        Average,
+        Volume,
+        Amount
+    };
+
+    /// @brief A sample is the window of bars ending at this date (included)
+    struct SampleAnchor
+    {
+        std::string symbol;
+        uint64_t date;
+    };
+
+    struct SampleGeneratorOptions
+    {
+        size_t window = 60;    // bars per sample
+        size_t batchSize = 256;
+        std::vector<SampleFeature> features = {SampleFeature::Open, SampleFeature::High, SampleFeature::Low, SampleFeature::Close, SampleFeature::Volume};
+        bool shuffle = true;   // the order of every epoch only depends on seed and the epoch number
+        uint64_t seed = 0;
+        size_t threads = 0;    // worker threads assembling a batch, 0 for one per hardware thread
+    };
+
+    /// @brief Turns anchors into batches of normalized windows, laid out [batch][window][feature].
+    /// Each window is copied out of its series and min-max normalized on its own, see NormalizeBars.
+    /// A background thread assembles the next batches into two staging buffers while the caller consumes the current one,
+    /// with the help of worker threads that live as long as the generator and keep their window buffer from batch to batch
+    /// @tparam T float or double
+    template <typename T>
+    struct SampleGenerator
+    {
+        /// @param symbols one per series
+        /// @param series bars of each symbol, not owned, must outlive the generator
+        /// @param anchors anchors whose symbol is unknown or whose date is missing or has fewer than window bars up to it are dropped, see DroppedAnchors
+        SampleGenerator(const std::vector<std::string>& symbols, const std::vector<const AugmentedBars*>& series,
+                        const std::vector<SampleAnchor>& anchors, const SampleGeneratorOptions& options);
+        ~SampleGenerator();
+
+        SampleGenerator(const SampleGenerator&) = delete;
+        SampleGenerator& operator=(const SampleGenerator&) = delete;
+
+        size_t SampleCount() const { return samples.size(); }
+        size_t BatchCount() const { return (samples.size() + options.batchSize - 1) / options.batchSize; }
+
+        /// @brief Number of values of one sample, window * features
+        size_t SampleSize() const { return options.window * options.features.size(); }
+
+        /// @brief Indices of the anchors that could not be turned into samples
+        const std::vector<size_t>& DroppedAnchors() const { return droppedAnchors; }
+
+        /// @brief Start (or restart) producing the batches of an epoch in the background
+        void StartEpoch(uint64_t epoch);
+
+        /// @brief Wait for the next batch of the epoch and copy it out
+        /// @param output room for batchSize * SampleSize() values
+        /// @param anchorIndices if not nullptr, set to the index (in the constructor's anchors) of each sample of the batch
+        /// @return the number of samples written, less than batchSize for the last batch, 0 once the epoch is over
+        size_t NextBatch(T* output, std::vector<size_t>* anchorIndices = nullptr);
+
+    private:
+        struct Sample
+        {
+            size_t anchorIndex;
+            const AugmentedBar* firstBar;
+        };
+
+        struct Slot
+        {
+            std::vector<T> values;
+            std::vector<size_t> anchorIndices;
+            size_t sampleCount = 0;
+            bool ready = false;
+        };
+
+        void Produce();
+        void FillSlot(size_t batch, Slot& slot);
+        void StopProducer();
+
+        /// @brief Fill the samples of the tasks of the current batch until none is left
+        /// @param window scratch of the calling thread
+        void RunTasks(std::vector<AugmentedBar>& window);
+        void RunWorker(size_t workerIndex);
+
+        SampleGeneratorOptions options;
+        std::vector<Sample> samples;
+        std::vector<size_t> droppedAnchors;
+        std::vector<size_t> order; // sample order of the current epoch
+
+        std::mutex mutex;
+        std::condition_variable condition;
+        Slot slots[2];
+        size_t nextToFill = 0;
+        size_t nextToTake = 0;
+        bool stopping = false;
+        std::thread producer;
+
+        // batch being filled by the producer and the workers, set by FillSlot under workerMutex
+        std::mutex workerMutex;
+        std::condition_variable workerCondition;
+        Slot* taskSlot = nullptr;
+        size_t taskFirst = 0;       // position in order of the first sample of the batch
+        size_t taskSampleCount = 0;
+        size_t taskCount = 0;
+        std::atomic<size_t> nextTask{0};
+        uint64_t taskGeneration = 0; // incremented for every batch handed to the workers
+        size_t busyWorkers = 0;
+        bool workersStopping = false;
+        std::vector<std::vector<AugmentedBar>> windows; // scratch of each thread, the producer's first
+        std::vector<std::thread> workers;
+    };
+
+    extern template struct SampleGenerator<float>;
+    extern template struct SampleGenerator<double>;
+}
@@ -0,0 +1,38 @@
+#include "SeriesCache.hpp"
+
+bool StockData::LoadSeries(const SeriesKey &key, Bars &bars)
+{
+    std::string filePath = GetFilePath(key.symbol, key.frequency, key.date);
+    std::string error;
+    if (filePath.empty())
+    {
+        return false;
+    }
+    if (!ReadBars(filePath, bars, error))
+    {
+        std::cerr << error << '\n';
+        return false;
+    }
+    return true;
+}
+
+bool StockData::LoadSeries(const SeriesKey &key, AugmentedBars &bars)
+{
+    Bars rawBars;
+    if (!LoadSeries(key, rawBars))
+    {
+        return false;
+    }
+    bars = AugmentedBars(rawBars);
+    return true;
+}
+
+size_t StockData::GetSeriesBytes(const Bars &bars)
+{
+    return sizeof(Bars) + bars.symbol.capacity() + bars.data.capacity() * sizeof(Bar);
+}
+
+size_t StockData::GetSeriesBytes(const AugmentedBars &bars)
+{
+    return sizeof(AugmentedBars) + bars.symbol.capacity() + bars.data.capacity() * sizeof(AugmentedBar);
+}
@@ -0,0 +1,226 @@
+#pragma once
+#include <cstddef>
+#include <cstdint>
+#include <functional>
+#include <future>
+#include <list>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <unordered_map>
+
+#include "StockData.hpp"
+
+namespace StockData
+{
+    /// @brief Identifies a loaded series, date is 0 for series that are not per day (e.g. .1d.bars)
+    struct SeriesKey
+    {
+        std::string symbol;
+        DataFrequency frequency = DataFrequency::Undefined;
+        uint64_t date = 0;
+
+        bool operator==(const SeriesKey& other) const = default;
+    };
+
+    struct SeriesKeyHash
+    {
+        size_t operator()(const SeriesKey& key) const
+        {
+            size_t hash = std::hash<std::string>()(key.symbol);
+            hash ^= std::hash<uint64_t>()(key.date) + 0x9e3779b97f4a7c15ULL + (hash << 6) + (hash >> 2);
+            hash ^= std::hash<int>()(static_cast<int>(key.frequency)) + 0x9e3779b97f4a7c15ULL + (hash << 6) + (hash >> 2);
+            return hash;
+        }
+    };
+
+    struct SeriesCacheStats
+    {
+        uint64_t hits = 0;
+        uint64_t misses = 0;          // lookups that triggered a load
+        uint64_t collapsedMisses = 0; // lookups that waited for a load already in flight
+        uint64_t evictions = 0;
+        uint64_t loadFailures = 0;
+        size_t entries = 0;
+        size_t bytes = 0;
+    };
+
+    /// @brief Loads a series file, see GetFilePath
+    /// @return true if the series could be loaded, false otherwise
+    bool LoadSeries(const SeriesKey& key, Bars& bars);
+
+    /// @brief Loads a series file and augments it, see AugmentedBars(const Bars&)
+    bool LoadSeries(const SeriesKey& key, AugmentedBars& bars);
+
+    /// @brief Approximate memory held by a series
+    size_t GetSeriesBytes(const Bars& bars);
+    size_t GetSeriesBytes(const AugmentedBars& bars);
+
+    /// @brief Thread-safe cache of loaded series with a byte budget and LRU eviction.
+    /// Series are handed out as shared immutable handles, so an evicted series stays alive as long as someone holds it.
+    /// Concurrent misses on the same key wait for a single load
+    template <typename T>
+    struct SeriesCache
+    {
+        using Handle = std::shared_ptr<const T>;
+        using Loader = std::function<bool(const SeriesKey&, T&)>;
+
+        /// @param byteBudget the cache evicts the least recently used series once it holds more than this
+        /// @param loader loads a series on a miss, LoadSeries by default
+        explicit SeriesCache(size_t byteBudget, Loader loader = [](const SeriesKey& key, T& series) { return LoadSeries(key, series); })
+            : budget(byteBudget), load(std::move(loader))
+        {}
+
+        SeriesCache(const SeriesCache&) = delete;
+        SeriesCache& operator=(const SeriesCache&) = delete;
+
+        Handle Get(const std::string& symbol, DataFrequency frequency, uint64_t date = 0)
+        {
+            return Get(SeriesKey{symbol, frequency, date});
+        }
+
+        /// @brief Get a series, loading it on a miss
+        /// @return nullptr if the series could not be loaded, failures are not cached.
+        /// An exception thrown by the loader is rethrown here and to the callers waiting on the same key
+        Handle Get(const SeriesKey& key)
+        {
+            std::unique_lock<std::mutex> lock(mutex);
+            auto it = entries.find(key);
+            if (it != entries.end())
+            {
+                ++stats.hits;
+                lru.splice(lru.begin(), lru, it->second.lruPosition);
+                return it->second.series;
+            }
+
+            auto loadingIt = loading.find(key);
+            if (loadingIt != loading.end())
+            {
+                ++stats.collapsedMisses;
+                std::shared_future<Handle> pending = loadingIt->second;
+                lock.unlock();
+                return pending.get();
+            }
+
+            ++stats.misses;
+            std::promise<Handle> promise;
+            loading.emplace(key, promise.get_future().share());
+            lock.unlock();
+
+            Handle handle;
+            try
+            {
+                auto series = std::make_shared<T>();
+                handle = load(key, *series) ? Handle(std::move(series)) : Handle();
+            }
+            catch (...)
+            {
+                // the key must not stay in loading, or every later Get of it would wait on a promise nobody fulfils
+                lock.lock();
+                loading.erase(key);
+                ++stats.loadFailures;
+                lock.unlock();
+                promise.set_exception(std::current_exception());
+                throw;
+            }
+
+            lock.lock();
+            loading.erase(key);
+            if (handle)
+            {
+                Insert(key, handle);
+            }
+            else
+            {
+                ++stats.loadFailures;
+            }
+            lock.unlock();
+
+            promise.set_value(handle);
+            return handle;
+        }
+
+        void Erase(const SeriesKey& key)
+        {
+            std::lock_guard<std::mutex> lock(mutex);
+            auto it = entries.find(key);
+            if (it != entries.end())
+            {
+                Remove(it);
+            }
+        }
+
+        void Clear()
+        {
+            std::lock_guard<std::mutex> lock(mutex);
+            entries.clear();
+            lru.clear();
+            stats.bytes = 0;
+            stats.entries = 0;
+        }
+
+        void SetByteBudget(size_t byteBudget)
+        {
+            std::lock_guard<std::mutex> lock(mutex);
+            budget = byteBudget;
+            EvictOverBudget();
+        }
+
+        SeriesCacheStats GetStats() const
+        {
+            std::lock_guard<std::mutex> lock(mutex);
+            return stats;
+        }
+
+    private:
+        struct Entry
+        {
+            Handle series;
+            size_t bytes;
+            typename std::list<SeriesKey>::iterator lruPosition;
+        };
+        using EntryMap = std::unordered_map<SeriesKey, Entry, SeriesKeyHash>;
+
+        void Insert(const SeriesKey& key, const Handle& series)
+        {
+            size_t bytes = GetSeriesBytes(*series);
+            if (bytes > budget)
+            {
+                return; // would evict everything and still not fit
+            }
+            lru.push_front(key);
+            entries.emplace(key, Entry{series, bytes, lru.begin()});
+            stats.bytes += bytes;
+            stats.entries = entries.size();
+            EvictOverBudget();
+        }
+
+        void Remove(typename EntryMap::iterator it)
+        {
+            stats.bytes -= it->second.bytes;
+            lru.erase(it->second.lruPosition);
+            entries.erase(it);
+            stats.entries = entries.size();
+        }
+
+        void EvictOverBudget()
+        {
+            while (stats.bytes > budget && !lru.empty())
+            {
+                Remove(entries.find(lru.back()));
+                ++stats.evictions;
+            }
+        }
+
+        mutable std::mutex mutex;
+        size_t budget;
+        Loader load;
+        std::list<SeriesKey> lru; // most recently used first
+        EntryMap entries;
+        std::unordered_map<SeriesKey, std::shared_future<Handle>, SeriesKeyHash> loading;
+        SeriesCacheStats stats;
+    };
+
+    using BarsCache = SeriesCache<Bars>;
+    using AugmentedBarsCache = SeriesCache<AugmentedBars>;
+}
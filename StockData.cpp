@@ -1,9 +1,21 @@
 #include "StockData.hpp"
 #include <iostream>
 #include <fstream>
+#include <filesystem>
+#include <new>
+#include <sys/mman.h>
 
 void StockData::ReadTicks(const char* buffer, const size_t& bufferSize, Ticks& ticks)
 {
+    STOCKDATA_METRIC_SCOPE(ReadTicks);
+    STOCKDATA_METRIC_IO(ReadTicks, bufferSize, 0);
+    if (bufferSize < StockData::TICK_INFO_SIZE)
+    {
+        std::cerr << "Buffer size is too small for Ticks" << std::endl;
+        ticks.Release();
+        ticks.tickCount = 0;
+        return;
+    }
     char* bufferPos = (char*)buffer;
     size_t dataSize = bufferSize - StockData::TICK_INFO_SIZE;
     size_t dataCount = dataSize / sizeof(StockData::Tick);
@@ -19,19 +31,35 @@ void StockData::ReadTicks(const char* buffer, const size_t& bufferSize, Ticks& t
     {
         std::cerr << "Data count mismatch: " << ticks.tickCount << " != " << dataCount << '\n';
     }
-    ticks.data = new StockData::Tick[dataCount];
-    memcpy(ticks.data, bufferPos, dataSize);
+    // only the ticks both announced by the header and present in the buffer are read
+    dataCount = std::min(dataCount, ticks.tickCount);
+    ticks.tickCount = dataCount;
+    ticks.Allocate(dataCount);
+    memcpy(ticks.data, bufferPos, dataCount * sizeof(StockData::Tick));
 }
 
-void StockData::ReadTicks(const std::string &filePath, Ticks &ticks)
+namespace
 {
-    std::ifstream file(filePath, std::ios::binary);
-    if (file.is_open())
+    /// @brief Shared by the ReadTicks overloads, the ticks go into the arena if there is one, into a new array otherwise
+    bool ReadTicksFile(const std::string &filePath, StockData::Ticks &ticks, StockData::TickArena *arena)
     {
+        STOCKDATA_METRIC_SCOPE(ReadTicks);
+        std::ifstream file(filePath, std::ios::binary);
+        if (!file.is_open())
+        {
+            std::cerr << "Failed to open file: " << filePath << '\n';
+            return false;
+        }
+
         // std::cout << "Opened file: " << filePath << '\n';
         file.seekg(0, std::ios::end);
         size_t fileSize = file.tellg();
         file.seekg(0, std::ios::beg);
+        if (fileSize < StockData::TICK_INFO_SIZE)
+        {
+            std::cerr << "Invalid tick file: " << filePath << '\n';
+            return false;
+        }
         size_t dataSize = fileSize - StockData::TICK_INFO_SIZE;
         size_t dataCount = dataSize / sizeof(StockData::Tick);
 
@@ -43,15 +71,99 @@ void StockData::ReadTicks(const std::string &filePath, Ticks &ticks)
         {
             std::cerr << "Data count mismatch: " << ticks.tickCount << " != " << dataCount << '\n';
         }
-        ticks.data = new StockData::Tick[dataCount];
-        file.read((char*)ticks.data, dataSize);
+        // only the ticks both announced by the header and present in the file are read, a partial trailing tick is left out
+        dataCount = std::min(dataCount, ticks.tickCount);
+        ticks.tickCount = dataCount;
+        if (arena != nullptr)
+        {
+            StockData::Tick* buffer = arena->Acquire(dataCount);
+            if (buffer == nullptr)
+            {
+                std::cerr << "Failed to allocate " << dataCount << " ticks for " << filePath << '\n';
+                ticks.Release();
+                ticks.tickCount = 0;
+                return false;
+            }
+            ticks.Borrow(buffer);
+        }
+        else
+        {
+            ticks.Allocate(dataCount);
+        }
+        file.read((char*)ticks.data, dataCount * sizeof(StockData::Tick));
+        STOCKDATA_METRIC_IO(ReadTicks, file.gcount() + StockData::TICK_INFO_SIZE, 1);
+        if (!file)
+        {
+            std::cerr << "Failed to read file: " << filePath << '\n';
+            ticks.Release();
+            ticks.tickCount = 0;
+            return false;
+        }
+        return true;
+    }
+}
+
+void StockData::ReadTicks(const std::string &filePath, Ticks &ticks)
+{
+    ReadTicksFile(filePath, ticks, nullptr);
+}
+
+bool StockData::ReadTicks(const std::string &filePath, Ticks &ticks, TickArena &arena)
+{
+    return ReadTicksFile(filePath, ticks, &arena);
+}
 
-        file.close();
+StockData::Tick* StockData::TickArena::Acquire(size_t count)
+{
+    if (count <= capacity && buffer != nullptr)
+    {
+        return buffer;
+    }
+    // grow by at least half, so days that get slightly longer one after the other do not reallocate every time
+    size_t newCapacity = std::max({count, capacity + capacity / 2, size_t(1)});
+    Release();
+
+    size_t bytes = newCapacity * sizeof(Tick);
+    if (!hugePages)
+    {
+        buffer = new (std::nothrow) Tick[newCapacity];
+        capacity = buffer != nullptr ? newCapacity : 0;
+        return buffer;
+    }
+
+    // explicit huge pages need pages reserved by the administrator (vm.nr_hugepages), fall back to transparent ones
+    size_t mappingBytes = (bytes + HUGE_PAGE_SIZE - 1) / HUGE_PAGE_SIZE * HUGE_PAGE_SIZE;
+    void* mapping = mmap(nullptr, mappingBytes, PROT_READ | PROT_WRITE, MAP_PRIVATE | MAP_ANONYMOUS | MAP_HUGETLB, -1, 0);
+    hugeTlb = mapping != MAP_FAILED;
+    if (!hugeTlb)
+    {
+        mapping = mmap(nullptr, mappingBytes, PROT_READ | PROT_WRITE, MAP_PRIVATE | MAP_ANONYMOUS, -1, 0);
+        if (mapping == MAP_FAILED)
+        {
+            return nullptr;
+        }
+        madvise(mapping, mappingBytes, MADV_HUGEPAGE);
+    }
+    buffer = static_cast<Tick*>(mapping);
+    mappedBytes = mappingBytes;
+    capacity = mappingBytes / sizeof(Tick);
+    return buffer;
+}
+
+void StockData::TickArena::Release()
+{
+    if (mappedBytes > 0)
+    {
+        munmap(buffer, mappedBytes);
     }
     else
     {
-        std::cerr << "Failed to open file: " << filePath << '\n';
+        delete[] buffer;
     }
+    buffer = nullptr;
+    capacity = 0;
+    mappedBytes = 0;
+    hugeTlb = false;
 }
 
 std::string StockData::GetFilePath(const std::string &symbol, DataFrequency frequency, ulong date)
@@ -63,24 +175,75 @@ std::string StockData::GetFilePath(const std::string &symbol, DataFrequency freq
         case DataFrequency::Bar1d:
             return DATA_DIR_1D + '/' + symbol + ".1d.bars";
         case DataFrequency::Tick:
-            // if (date != 0)
-            // {
-            //     return DATA_DIR_TICK + "/" + symbol + "." + std::to_string(date) + ".ticks";
-            // }
-            // else
-            // {
-            //     std::cerr << "Date is required for tick data.\n";
-            //     return std::string();
-            // }
-            return std::string(); // tick data loading is not supported yet
+            if (date != 0)
+            {
+                return DATA_DIR_TICK + "/" + symbol + "." + std::to_string(date) + ".ticks";
+            }
+            else
+            {
+                std::cerr << "Date is required for tick data.\n";
+                return std::string();
+            }
         default:
             std::cerr << "Unsupported frequency.\n";
             return std::string();
     }
 }
 
+bool StockData::ListMinuteBarDates(const std::string &symbol, std::vector<uint64_t> &dates, std::string &error)
+{
+    const std::string directory = DATA_DIR_1M + '/' + symbol;
+    const std::string suffix = ".1m.bars";
+
+    dates.clear();
+    std::error_code errorCode;
+    for (std::filesystem::directory_iterator it(directory, errorCode), end; !errorCode && it != end; it.increment(errorCode))
+    {
+        std::string fileName = it->path().filename().string();
+        if (fileName.size() <= suffix.size() || fileName.compare(fileName.size() - suffix.size(), suffix.size(), suffix) != 0)
+        {
+            continue;
+        }
+        std::string dateString = fileName.substr(0, fileName.size() - suffix.size());
+        // dates are YYYYMMDD, longer digit strings are other files and could overflow stoull
+        if (dateString.size() > 8 || dateString.find_first_not_of("0123456789") != std::string::npos)
+        {
+            continue;
+        }
+        dates.push_back(std::stoull(dateString));
+    }
+    if (errorCode)
+    {
+        error = "Failed to list directory " + directory + ": " + errorCode.message();
+        return false;
+    }
+
+    std::sort(dates.begin(), dates.end());
+    return true;
+}
+
+size_t StockData::GetBarsDataSize(const std::string &filePath, size_t fileSize)
+{
+    size_t dataSize = fileSize - StockData::BAR_INFO_SIZE;
+
+    const std::string suffix = ".1m.bars";
+    if (filePath.size() >= suffix.size() && filePath.compare(filePath.size() - suffix.size(), suffix.size(), suffix) == 0)
+    {
+        dataSize -= sizeof(uint16_t);
+    }
+    return dataSize;
+}
+
 void StockData::ReadBars(const char *buffer, size_t bufferSize, Bars &bars)
 {
+    STOCKDATA_METRIC_SCOPE(ReadBars);
+    STOCKDATA_METRIC_IO(ReadBars, bufferSize, 0);
+    if (bufferSize < StockData::BAR_INFO_SIZE)
+    {
+        std::cerr << "Buffer size is too small for Bars" << std::endl;
+        bars.data.clear();
+        return;
+    }
     const char *bufferPos = buffer;
     size_t dataSize = bufferSize - StockData::BAR_INFO_SIZE;
     size_t barCount = dataSize / sizeof(StockData::Bar);
@@ -93,37 +256,115 @@ void StockData::ReadBars(const char *buffer, size_t bufferSize, Bars &bars)
     bufferPos += sizeof(DataFrequency);
 
     bars.data = std::vector<StockData::Bar>(barCount);
-    memcpy(bars.data.data(), bufferPos, dataSize);
+    memcpy(bars.data.data(), bufferPos, barCount * sizeof(StockData::Bar)); // a partial trailing bar is left out
 }
 
 void StockData::ReadBars(const std::string &filePath, Bars &bars)
 {
+    std::string error;
+    if (!StockData::ReadBars(filePath, bars, error))
+    {
+        std::cerr << error << '\n';
+    }
+}
+
+bool StockData::ReadBars(const std::string &filePath, Bars &bars, std::string &error)
+{
+    STOCKDATA_METRIC_SCOPE(ReadBars);
     std::ifstream file(filePath, std::ios::binary);
-    if (file.is_open())
+    if (!file.is_open())
     {
-        file.seekg(0, std::ios::end);
-        size_t fileSize = file.tellg();
-        file.seekg(0, std::ios::beg);
-        size_t dataSize = fileSize - StockData::BAR_INFO_SIZE;
+        error = "Failed to open file: " + filePath;
+        return false;
+    }
 
-        std::string fileSuffix = filePath.substr(filePath.size() - 8);
-        if (fileSuffix == ".1m.bars")
-        {
-            dataSize -= sizeof(uint16_t);
-        }
-        size_t dataCount = dataSize / sizeof(StockData::Bar);
-        
-        bars.symbol.resize(BARS_SYMBOL_SIZE + 1, '\0'); // +1 for null terminator
-        file.read(bars.symbol.data(), BARS_SYMBOL_SIZE);
+    file.seekg(0, std::ios::end);
+    size_t fileSize = file.tellg();
+    file.seekg(0, std::ios::beg);
+    size_t dataSize = fileSize >= StockData::BAR_INFO_SIZE ? StockData::GetBarsDataSize(filePath, fileSize) : fileSize;
+    if (dataSize >= fileSize) // the header, or the trailer of .1m.bars, does not fit
+    {
+        error = "File too small for bars: " + filePath;
+        return false;
+    }
+    size_t dataCount = dataSize / sizeof(StockData::Bar);
+
+    bars.symbol.resize(BARS_SYMBOL_SIZE + 1, '\0'); // +1 for null terminator
+    file.read(bars.symbol.data(), BARS_SYMBOL_SIZE);
 
-        file.read((char*)&bars.frequency, sizeof(DataFrequency));
-        
-        bars.data = std::vector<StockData::Bar>(dataCount);
-        file.read((char*)bars.data.data(), dataSize);
+    file.read((char*)&bars.frequency, sizeof(DataFrequency));
 
+    bars.data = std::vector<StockData::Bar>(dataCount);
+    file.read((char*)bars.data.data(), dataCount * sizeof(StockData::Bar));
+    STOCKDATA_METRIC_IO(ReadBars, file.gcount() + StockData::BAR_INFO_SIZE, 1);
+    if (!file)
+    {
+        error = "Failed to read file: " + filePath;
+        return false;
     }
-    else
+    return true;
+}
+
+bool StockData::WriteBars(const std::string &filePath, const Bars &bars, std::string &error)
+{
+    std::ofstream file(filePath, std::ios::binary | std::ios::trunc);
+    if (!file.is_open())
+    {
+        error = "Failed to open file for writing: " + filePath;
+        return false;
+    }
+
+    char symbol[BARS_SYMBOL_SIZE] = {};
+    memcpy(symbol, bars.symbol.data(), std::min(bars.symbol.size(), BARS_SYMBOL_SIZE));
+    file.write(symbol, BARS_SYMBOL_SIZE);
+    file.write((const char*)&bars.frequency, sizeof(DataFrequency));
+    file.write((const char*)bars.data.data(), bars.data.size() * sizeof(Bar));
+
+    const std::string suffix = ".1m.bars";
+    if (filePath.size() >= suffix.size() && filePath.compare(filePath.size() - suffix.size(), suffix.size(), suffix) == 0)
+    {
+        uint16_t trailer = 0;
+        file.write((const char*)&trailer, sizeof(uint16_t));
+    }
+    if (!file)
+    {
+        error = "Failed to write file: " + filePath;
+        return false;
+    }
+    return true;
+}
+
+bool StockData::WriteTicks(const std::string &filePath, const Ticks &ticks, std::string &error)
+{
+    std::ofstream file(filePath, std::ios::binary | std::ios::trunc);
+    if (!file.is_open())
+    {
+        error = "Failed to open file for writing: " + filePath;
+        return false;
+    }
+
+    file.write(ticks.symbol, SYMBOL_SIZE);
+    file.write((const char*)&ticks.date, sizeof(uint64_t));
+    file.write((const char*)&ticks.tickCount, sizeof(size_t));
+    file.write((const char*)ticks.data, ticks.tickCount * sizeof(Tick));
+    if (!file)
     {
-        std::cerr << "Failed to open file: " << filePath << '\n';
+        error = "Failed to write file: " + filePath;
+        return false;
     }
-}
\ No newline at end of file
+    return true;
+}
+
+void StockData::WriteAugmentedBars(const AugmentedBars &bars, std::vector<char> &buffer)
+{
+    buffer.assign(AUGMENTED_BAR_INFO_SIZE + bars.data.size() * sizeof(AugmentedBar), '\0');
+    char* bufferPos = buffer.data();
+
+    memcpy(bufferPos, bars.symbol.data(), std::min(bars.symbol.size(), AU_SYMBOL_SIZE));
+    bufferPos += AU_SYMBOL_SIZE;
+    memcpy(bufferPos, &bars.frequency, sizeof(int));
+    bufferPos += sizeof(int);
+    memcpy(bufferPos, &bars.averageDistance, sizeof(double));
+    bufferPos += sizeof(double);
+    memcpy(bufferPos, bars.data.data(), bars.data.size() * sizeof(AugmentedBar));
+}
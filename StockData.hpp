@@ -1,11 +1,15 @@
 #pragma once
+#include <algorithm>
 #include <cstddef>
 #include <cstdint>
+#include <span>
 #include <vector>
 #include <cstring>
 #include <string>
 #include <iostream>
+#include <utility>
 
+#include "Metrics.hpp"
 #include "utils/misc.hpp"
 
 namespace StockData
@@ -13,7 +17,7 @@ namespace StockData
     constexpr size_t SYMBOL_SIZE = 8; // 6 characters + null terminator + 1 padding
     constexpr size_t BARS_SYMBOL_SIZE = 6;
     constexpr size_t AU_SYMBOL_SIZE = 12;
-    constexpr size_t TICK_INFO_SIZE = StockData::SYMBOL_SIZE - sizeof(uint32_t) - sizeof(size_t);
+    constexpr size_t TICK_INFO_SIZE = StockData::SYMBOL_SIZE + sizeof(uint64_t) + sizeof(size_t); // symbol + date + tick count
     constexpr size_t BAR_INFO_SIZE = BARS_SYMBOL_SIZE + sizeof(int);
     constexpr size_t AUGMENTED_BAR_INFO_SIZE = AU_SYMBOL_SIZE + sizeof(int) + sizeof(double); // + average distance
 
@@ -36,12 +40,132 @@ namespace StockData
         double bidPrices[5];
     };
 
+    /// @brief Reusable buffer that ReadTicks can load ticks into instead of allocating a new array for every day.
+    /// It grows to the largest day read so far and is recycled by the next ReadTicks, so the Ticks read into it
+    /// are only valid until then. Optionally backed by huge pages, which cuts TLB misses on multi-MB days
+    struct TickArena
+    {
+        static constexpr size_t HUGE_PAGE_SIZE = size_t(2) << 20;
+
+        /// @param hugePages back the buffer with explicit huge pages (MAP_HUGETLB) if the system has some reserved,
+        /// otherwise with regular pages advised for transparent huge pages
+        explicit TickArena(bool hugePages = false) : hugePages(hugePages) {}
+        ~TickArena() { Release(); }
+
+        TickArena(const TickArena&) = delete;
+        TickArena& operator=(const TickArena&) = delete;
+
+        /// @brief Room for count ticks, valid until the next Acquire or Release. The previous contents are not kept
+        /// @return nullptr if the memory could not be allocated
+        Tick* Acquire(size_t count);
+
+        /// @brief Give the buffer back to the system
+        void Release();
+
+        size_t Capacity() const { return capacity; }
+
+        /// @return true if the current buffer is made of explicit huge pages
+        bool HasHugePages() const { return hugeTlb; }
+
+    private:
+        bool hugePages;
+        Tick* buffer = nullptr;
+        size_t capacity = 0;    // in ticks
+        size_t mappedBytes = 0; // size of the mapping when huge pages were asked for, 0 for a heap buffer
+        bool hugeTlb = false;
+    };
+
     struct Ticks
     {
-        char symbol[SYMBOL_SIZE];
-        uint64_t date;
-        size_t tickCount;
-        Tick* data;
+        char symbol[SYMBOL_SIZE] = {};
+        uint64_t date = 0;
+        size_t tickCount = 0;
+        Tick* data = nullptr; // owned and freed with the Ticks, unless borrowed, e.g. from a TickArena
+
+        Ticks() = default;
+
+        Ticks(const Ticks& other)
+        {
+            *this = other;
+        }
+
+        Ticks(Ticks&& other) noexcept
+        {
+            *this = std::move(other);
+        }
+
+        ~Ticks()
+        {
+            Release();
+        }
+
+        /// @brief Deep copy, the copy owns its data even if other's is borrowed
+        Ticks& operator=(const Ticks& other)
+        {
+            if (this != &other)
+            {
+                memcpy(symbol, other.symbol, SYMBOL_SIZE);
+                date = other.date;
+                tickCount = other.tickCount;
+                Allocate(other.tickCount);
+                if (other.tickCount > 0)
+                {
+                    memcpy(data, other.data, other.tickCount * sizeof(Tick));
+                }
+            }
+            return *this;
+        }
+
+        Ticks& operator=(Ticks&& other) noexcept
+        {
+            if (this != &other)
+            {
+                Release();
+                memcpy(symbol, other.symbol, SYMBOL_SIZE);
+                date = other.date;
+                tickCount = other.tickCount;
+                data = other.data;
+                ownsData = other.ownsData;
+
+                other.tickCount = 0;
+                other.data = nullptr;
+                other.ownsData = false;
+            }
+            return *this;
+        }
+
+        /// @brief Replace data with an owned, uninitialized array of count ticks. tickCount is left to the caller
+        Tick* Allocate(size_t count)
+        {
+            Release();
+            data = new Tick[count];
+            ownsData = true;
+            return data;
+        }
+
+        /// @brief Replace data with ticks owned by someone else, who must keep them alive as long as they are used
+        void Borrow(Tick* ticks)
+        {
+            Release();
+            data = ticks;
+            ownsData = false;
+        }
+
+        /// @brief Free data if owned, data is nullptr afterwards
+        void Release()
+        {
+            if (ownsData)
+            {
+                delete[] data;
+            }
+            data = nullptr;
+            ownsData = false;
+        }
+
+        bool OwnsData() const { return ownsData; }
+
+    private:
+        bool ownsData = false;
     };
 
     enum class DataFrequency
@@ -49,6 +173,10 @@ namespace StockData
         Undefined = 0,
         Tick = 3,
         Bar1m = 60,
+        Bar5m = 300,
+        Bar15m = 900,
+        Bar30m = 1800,
+        Bar60m = 3600,
         Bar1d = 14400 //  4 hours * 60 minutes * 60 seconds
     };
 
@@ -75,6 +203,90 @@ namespace StockData
         }
     };
 
+    /// @brief A window of bars around a date, see GetWindowFromDate.
+    /// Positions outside of the series are not materialised, they are only counted as padding
+    template <typename T>
+    struct BarsWindow
+    {
+        std::span<const T> bars;
+        size_t leadingPad = 0;  // missing positions before the first bar
+        size_t trailingPad = 0; // missing positions after the last bar
+
+        size_t size() const { return leadingPad + bars.size() + trailingPad; }
+
+        /// @brief Bar at a position of the window, nullptr for padding
+        const T* operator[](size_t i) const
+        {
+            if (i < leadingPad || i - leadingPad >= bars.size())
+            {
+                return nullptr;
+            }
+            return &bars[i - leadingPad];
+        }
+    };
+
+    /// @brief Binary search for a time in a series sorted by time in ascending order
+    /// @param data the series, e.g. Bars::data or AugmentedBars::data
+    /// @param time the time to look for
+    /// @param index set to the index of the first element with the given time, if found
+    /// @return true if the time was found, false otherwise
+    template <typename T>
+    bool FindTimeIndex(const std::vector<T>& data, uint64_t time, size_t& index)
+    {
+        auto it = std::lower_bound(data.begin(), data.end(), time,
+            [](const T& element, uint64_t value) { return element.time < value; });
+        if (it == data.end() || it->time != time)
+        {
+            return false;
+        }
+        index = it - data.begin();
+        return true;
+    }
+
+    /// @brief Find a specific number of bars from a given date (included), without copying them
+    /// @param data the series, sorted by time in ascending order
+    /// @param date the date from which to search
+    /// @param count number of bars, backward windows end at the date and span count bars, forward windows start at the date and span count + 1 bars
+    /// @param backward true for bars up to the given date, false for bars from the given date
+    /// @param window set to the bars in range, plus the number of positions that fall outside of the series
+    /// @return true if the date was found, false otherwise
+    template <typename T>
+    bool GetWindowFromDate(const std::vector<T>& data, size_t date, size_t count, bool backward, BarsWindow<T>& window)
+    {
+        window = BarsWindow<T>();
+
+        size_t dateIdx = 0;
+        if (!FindTimeIndex(data, date, dateIdx))
+        {
+            return false;
+        }
+
+        long startIdx, endIdx;
+        long max = data.size() - 1;
+        if (backward)
+        {
+            startIdx = static_cast<long>(dateIdx) - static_cast<long>(count) + 1;
+            endIdx = dateIdx;
+        }
+        else
+        {
+            startIdx = dateIdx;
+            endIdx = dateIdx + count;
+        }
+
+        if (endIdx < startIdx)
+        {
+            return true;
+        }
+
+        long firstIdx = std::max(startIdx, 0L);
+        long lastIdx = std::min(endIdx, max);
+        window.leadingPad = firstIdx - startIdx;
+        window.trailingPad = endIdx - lastIdx;
+        window.bars = std::span<const T>(data.data() + firstIdx, lastIdx - firstIdx + 1);
+        return true;
+    }
+
     struct Bars
     {
         std::string symbol;
@@ -92,6 +304,9 @@ namespace StockData
             data = other.data;
         }
 
+        // Move constructor
+        Bars(Bars&& other) noexcept = default;
+
         /// @brief Find a specific number of bars from a given date (included)
         /// @param date the date from which to search
         /// @param count positive for bars after the given date, negative for otherwise
@@ -99,69 +314,41 @@ namespace StockData
         /// @return true if any bars were found, false otherwise
         bool GetNBarsFromDate(size_t date, size_t count, bool backward, std::vector<const Bar*>& results) const
         {
+            STOCKDATA_METRIC_SCOPE(GetNBarsFromDate);
             results.clear();
 
-            size_t dateIdx = 0;
-            bool dateFound = false;
-            for (size_t i = 0; i < data.size(); ++i)
+            BarsWindow<Bar> window;
+            if (!GetWindowFromDate(date, count, backward, window))
             {
-                if (data[i].time == date)
-                {
-                    dateIdx = i;
-                    dateFound = true;
-                    break;
-                }
+                return false;
             }
 
-            if (dateFound)
+            results.reserve(window.size());
+            results.insert(results.end(), window.leadingPad, nullptr);
+            for (const Bar& bar : window.bars)
             {
-                bool fillData = false; // fill with nullptr when no data is available
-                long startIdx, endIdx, currentIdx;
-                long min = 0, max = data.size() - 1;
-                if (backward)
-                {
-                    startIdx = dateIdx - count + 1;
-                    endIdx = dateIdx;
-                }
-                else
-                {
-                    startIdx = dateIdx;
-                    endIdx = dateIdx + count;
-                }
-
-                currentIdx = startIdx;
-                if (currentIdx < min)
-                {
-                    for (long i = currentIdx; i < min; ++i)
-                    {
-                        results.push_back(nullptr);
-                    }
-                    currentIdx = 0;
-                }
+                results.push_back(&bar);
+            }
+            results.insert(results.end(), window.trailingPad, nullptr);
+            return true;
+        }
 
-                for (long i = currentIdx; i <= endIdx; ++i)
-                {
-                    if (i > max)
-                    {
-                        for (long j = i; j <= endIdx; ++j)
-                        {
-                            results.push_back(nullptr);
-                        }
-                        break;
-                    }
-
-                    // std::cout << "pushing: " << i << std::endl;
-                    results.push_back(&data[i]);
-                    // std::cout << "pushed: " << i << std::endl;
-                }
+        /// @brief Find a specific number of bars from a given date (included), without copying them
+        /// @param date the date from which to search
+        /// @param count number of bars, same as GetNBarsFromDate
+        /// @param backward true for bars up to the given date, false for bars from the given date
+        /// @param window set to the bars in range plus the padding on each side, see StockData::GetWindowFromDate
+        /// @return true if the date was found, false otherwise
+        bool GetWindowFromDate(size_t date, size_t count, bool backward, BarsWindow<Bar>& window) const
+        {
+            return StockData::GetWindowFromDate(data, date, count, backward, window);
+        }
 
-                return true;
-            }
-            else
-            {
-                // std::cout << "Returning false" << std::endl;
-                return false;
-            }
+        /// @brief Index of the bar at the given time, by binary search
+        /// @return true if found, false otherwise
+        bool FindDateIndex(uint64_t date, size_t& index) const
+        {
+            return FindTimeIndex(data, date, index);
         }
 
         void Clear()
@@ -181,6 +368,8 @@ namespace StockData
             return *this;
         }
 
+        Bars& operator=(Bars&& other) noexcept = default;
+
         ~Bars()
         {
             data.clear();
@@ -227,6 +416,15 @@ namespace StockData
         }
     };
 
+    /// @brief Min-max normalize bars in place: prices (open, high, low, close, average) by the lowest low and highest high,
+    /// volume and amount by their own range. Normalized values are 0.0 when a range is 0.
+    /// Uses AVX2 when the CPU supports it, the result is bit-identical to the scalar code.
+    /// @param bars
+    /// @param count
+    void NormalizeBars(AugmentedBar* bars, size_t count);
+
+    struct AdjustedBarsView;
+
     struct AugmentedBars
     {
         std::string symbol;
@@ -253,6 +451,10 @@ namespace StockData
             data(other.data)
         {}
 
+        AugmentedBars(AugmentedBars&& other) noexcept = default;
+        AugmentedBars& operator=(const AugmentedBars& other) = default;
+        AugmentedBars& operator=(AugmentedBars&& other) noexcept = default;
+
         AugmentedBars(const Bars& rawBars)
         {
             symbol = rawBars.symbol;
@@ -284,6 +486,9 @@ namespace StockData
             }
         }
 
+        /// @brief Same as above for bars adjusted by a view, the average price is adjusted too. Defined in Adjustment.cpp
+        AugmentedBars(const AdjustedBarsView& view);
+
         /// @brief Read an AugmentedBars from bytes
         /// @param buffer
         /// @param bufferSize
@@ -313,67 +518,30 @@ namespace StockData
 
         }
 
+        /// @brief Min-max normalize the whole series, see NormalizeBars
         void Normalize()
         {
-            // find max and min
-            double priceMax = 0.0;
-            double priceMin = std::numeric_limits<double>::max();
-            double volumeMax = 0.0;
-            double volumeMin = std::numeric_limits<double>::max();
-            double amountMax = 0.0;
-            double amountMin = std::numeric_limits<double>::max();
-            for (const auto& bar : data)
+            NormalizeBars(data.data(), data.size());
+        }
+
+        /// @brief Min-max normalize bars [first, first + count) with their own min and max, the rest of the series is untouched
+        void NormalizeRange(size_t first, size_t count)
+        {
+            if (first >= data.size())
             {
-                if (bar.high > priceMax) priceMax = bar.high;
-                if (bar.low < priceMin) priceMin = bar.low;
-                if (bar.volume > volumeMax) volumeMax = bar.volume;
-                if (bar.volume < volumeMin) volumeMin = bar.volume;
-                if (bar.amount > amountMax) amountMax = bar.amount;
-                if (bar.amount < amountMin) amountMin = bar.amount;
+                return;
             }
+            NormalizeBars(data.data() + first, std::min(count, data.size() - first));
+        }
 
-            double priceRange = priceMax - priceMin;
-            double volumeRange = volumeMax - volumeMin;
-            double amountRange = amountMax - amountMin;
-
-            for (auto& bar : data)
+        /// @brief Min-max normalize the bars of a window returned by GetWindowFromDate, padding is ignored
+        void NormalizeWindow(const BarsWindow<AugmentedBar>& window)
+        {
+            if (window.bars.empty())
             {
-                if (priceRange != 0.0)
-                {
-                    bar.openNormalized = (bar.open - priceMin) / priceRange;
-                    bar.highNormalized = (bar.high - priceMin) / priceRange;
-                    bar.lowNormalized = (bar.low - priceMin) / priceRange;
-                    bar.closeNormalized = (bar.close - priceMin) / priceRange;
-                    bar.averageNormalized = (bar.average - priceMin) / priceRange;
-                }
-                else
-                {
-                    bar.openNormalized = 0.0;
-                    bar.highNormalized = 0.0;
-                    bar.lowNormalized = 0.0;
-                    bar.closeNormalized = 0.0;
-                    bar.averageNormalized = 0.0;
-                }
-
-                if (volumeRange != 0.0)
-                {
-                    bar.volumeNormalized = (bar.volume - volumeMin) / volumeRange;
-                }
-                else
-                {
-                    bar.volumeNormalized = 0.0;
-                }
-
-                if (amountRange != 0.0)
-                {
-                    bar.amountNormalized = (bar.amount - amountMin) / amountRange;
-                }
-                else
-                {
-                    bar.amountNormalized = 0.0;
-                }
-
+                return;
             }
+            NormalizeRange(window.bars.data() - data.data(), window.bars.size());
         }
 
         /// @brief Find a specific number of bars from a given date (included)
@@ -383,68 +551,38 @@ namespace StockData
         /// @return true if any bars were found, false otherwise
         bool GetNBarsFromDate(size_t date, size_t count, bool backward, std::vector<AugmentedBar>& results) const
         {
+            STOCKDATA_METRIC_SCOPE(GetNBarsFromDate);
             results.clear();
 
-            size_t dateIdx = 0;
-            bool dateFound = false;
-            for (size_t i = 0; i < data.size(); ++i)
+            BarsWindow<AugmentedBar> window;
+            if (!GetWindowFromDate(date, count, backward, window))
             {
-                if (data[i].time == date)
-                {
-                    dateIdx = i;
-                    dateFound = true;
-                    break;
-                }
+                return false;
             }
 
-            if (dateFound)
-            {
-                long startIdx, endIdx, currentIdx;
-                long min = 0, max = data.size() - 1;
-                if (backward)
-                {
-                    startIdx = dateIdx - count + 1;
-                    endIdx = dateIdx;
-                }
-                else
-                {
-                    startIdx = dateIdx;
-                    endIdx = dateIdx + count;
-                }
-
-                currentIdx = startIdx;
-                if (currentIdx < min)
-                {
-                    for (long i = currentIdx; i < min; ++i)
-                    {
-                        results.push_back(AugmentedBar());
-                    }
-                    currentIdx = 0;
-                }
+            results.reserve(window.size());
+            results.insert(results.end(), window.leadingPad, AugmentedBar());
+            results.insert(results.end(), window.bars.begin(), window.bars.end());
+            results.insert(results.end(), window.trailingPad, AugmentedBar());
+            return true;
+        }
 
-                for (long i = currentIdx; i <= endIdx; ++i)
-                {
-                    if (i > max)
-                    {
-                        for (long j = i; j <= endIdx; ++j)
-                        {
-                            results.push_back(AugmentedBar());
-                        }
-                        break;
-                    }
-
-                    // std::cout << "pushing: " << i << std::endl;
-                    results.push_back(data[i]);
-                    // std::cout << "pushed: " << i << std::endl;
-                }
+        /// @brief Find a specific number of bars from a given date (included), without copying them
+        /// @param date the date from which to search
+        /// @param count number of bars, same as GetNBarsFromDate
+        /// @param backward true for bars up to the given date, false for bars from the given date
+        /// @param window set to the bars in range plus the padding on each side, see StockData::GetWindowFromDate
+        /// @return true if the date was found, false otherwise
+        bool GetWindowFromDate(size_t date, size_t count, bool backward, BarsWindow<AugmentedBar>& window) const
+        {
+            return StockData::GetWindowFromDate(data, date, count, backward, window);
+        }
 
-                return true;
-            }
-            else
-            {
-                // std::cout << "Returning false" << std::endl;
-                return false;
-            }
+        /// @brief Index of the bar at the given time, by binary search
+        /// @return true if found, false otherwise
+        bool FindDateIndex(uint64_t date, size_t& index) const
+        {
+            return FindTimeIndex(data, date, index);
         }
 
         void Clear()
@@ -465,8 +603,30 @@ namespace StockData
     void ReadTicks(const char* buffer, const size_t& bufferSize, Ticks& ticks);
     void ReadTicks(const std::string& filePath, Ticks& ticks);
 
+    /// @brief Reads a tick file into an arena instead of a new array, ticks.data borrows the arena's buffer
+    /// and is only valid until the arena is used again
+    /// @return true if the file was read, false otherwise
+    bool ReadTicks(const std::string& filePath, Ticks& ticks, TickArena& arena);
+
+    /// @brief Writes ticks in the layout ReadTicks reads: symbol, date, tick count, then the ticks
+    /// @param error set to the reason of the failure, if any
+    /// @return true if the file was written, false otherwise
+    bool WriteTicks(const std::string& filePath, const Ticks& ticks, std::string& error);
+
     std::string GetFilePath(const std::string& symbol, DataFrequency frequency, ulong date = 0);
 
+    /// @brief Dates that have a .1m.bars file in the directory of a symbol, files not named after a date (at most 8 digits) are skipped
+    /// @param symbol
+    /// @param dates the dates in ascending order, gets cleared in this function
+    /// @param error set to the reason of the failure, if any
+    /// @return true if the directory could be listed, false otherwise
+    bool ListMinuteBarDates(const std::string& symbol, std::vector<uint64_t>& dates, std::string& error);
+
+    /// @brief Size of the bar payload of a bars file, i.e. without the header and the trailing uint16_t of .1m.bars files
+    /// @param filePath used to tell .1m.bars from .1d.bars
+    /// @param fileSize total size of the file in bytes, must be at least BAR_INFO_SIZE
+    size_t GetBarsDataSize(const std::string& filePath, size_t fileSize);
+
     /// @brief Reads bars data from bytes
     /// @param buffer
     /// @param bufferSize
@@ -478,6 +638,23 @@ namespace StockData
     /// @param bars
     void ReadBars(const std::string& filePath, Bars& bars);
 
+    /// @brief Reads bars data from a binary file, reporting failures to the caller instead of std::cerr
+    /// @param filePath
+    /// @param bars
+    /// @param error set to the reason of the failure, if any
+    /// @return true if the file was read, false otherwise
+    bool ReadBars(const std::string& filePath, Bars& bars, std::string& error);
+
+    /// @brief Writes bars in the layout ReadBars reads: symbol, frequency, then the bars, plus the trailing uint16_t of .1m.bars files
+    /// @param filePath used to tell .1m.bars from .1d.bars, see GetBarsDataSize
+    /// @param error set to the reason of the failure, if any
+    /// @return true if the file was written, false otherwise
+    bool WriteBars(const std::string& filePath, const Bars& bars, std::string& error);
+
+    /// @brief Serializes bars in the layout AugmentedBars(char*, size_t) reads
+    /// @param buffer gets cleared in this function
+    void WriteAugmentedBars(const AugmentedBars& bars, std::vector<char>& buffer);
+
     enum EventTypes
     {
         LimitUp,
@@ -0,0 +1,253 @@
+#include "SyntheticData.hpp"
+#include "Aggregation.hpp"
+#include <algorithm>
+#include <chrono>
+#include <cmath>
+#include <filesystem>
+
+namespace
+{
+    using StockData::Bar;
+    using StockData::Bars;
+    using StockData::DataFrequency;
+
+    constexpr double LIMIT_RATIO = 0.1;      // daily price limit of main board A shares
+    constexpr double PRICE_STEP = 0.01;
+    constexpr double LOT = 100.0;
+    constexpr uint64_t SESSION_SECONDS = 4 * 3600;
+
+    /// @brief SplitMix64: tiny, fast and fully specified, so a seed gives the same numbers everywhere
+    struct Random
+    {
+        uint64_t state;
+
+        uint64_t Next()
+        {
+            uint64_t z = (state += 0x9E3779B97F4A7C15ull);
+            z = (z ^ (z >> 30)) * 0xBF58476D1CE4E5B9ull;
+            z = (z ^ (z >> 27)) * 0x94D049BB133111EBull;
+            return z ^ (z >> 31);
+        }
+
+        /// @brief Uniform in [0, 1)
+        double Uniform() { return (Next() >> 11) * 0x1.0p-53; }
+
+        /// @brief Roughly standard normal, the sum of four uniforms scaled to unit variance
+        double Normal() { return (Uniform() + Uniform() + Uniform() + Uniform() - 2.0) * 1.7320508075688772; }
+
+        /// @brief Whole number of lots, at least one
+        double Lots(double maxLots) { return LOT * (1.0 + std::floor(Uniform() * maxLots)); }
+    };
+
+    /// @brief Independent stream of a symbol and date, so one file can be regenerated without the others
+    Random MakeRandom(uint64_t seed, const std::string& symbol, uint64_t date, uint64_t stream)
+    {
+        uint64_t hash = 0xCBF29CE484222325ull; // FNV-1a of the symbol
+        for (char c : symbol)
+        {
+            hash = (hash ^ static_cast<unsigned char>(c)) * 0x100000001B3ull;
+        }
+        Random random{seed ^ hash};
+        random.state ^= random.Next() + date;
+        random.state ^= random.Next() + stream;
+        return random;
+    }
+
+    double RoundPrice(double price)
+    {
+        return std::max(PRICE_STEP, std::round(price / PRICE_STEP) * PRICE_STEP);
+    }
+
+    /// @brief Bar moving from previousClose by a return of about volatility, kept within the limits of limitBase
+    Bar MakeBar(Random& random, uint64_t time, double previousClose, double limitBase, double volatility, double maxLots)
+    {
+        double limitUp = RoundPrice(limitBase * (1.0 + LIMIT_RATIO));
+        double limitDown = RoundPrice(limitBase * (1.0 - LIMIT_RATIO));
+        auto limit = [&](double price) { return std::clamp(RoundPrice(price), limitDown, limitUp); };
+
+        Bar bar;
+        bar.time = time;
+        bar.open = limit(previousClose * (1.0 + 0.3 * volatility * random.Normal()));
+        bar.close = limit(previousClose * (1.0 + volatility * random.Normal()));
+        bar.high = std::max({limit(std::max(bar.open, bar.close) * (1.0 + 0.5 * volatility * random.Uniform())), bar.open, bar.close});
+        bar.low = std::min({limit(std::min(bar.open, bar.close) * (1.0 - 0.5 * volatility * random.Uniform())), bar.open, bar.close});
+        bar.volume = random.Lots(maxLots);
+        bar.amount = bar.volume * (bar.low + (bar.high - bar.low) * (0.25 + 0.5 * random.Uniform()));
+        return bar;
+    }
+
+    /// @brief HHMMSS of a number of seconds into the trading day, 09:30-11:30 then 13:00-15:00
+    uint64_t GetSessionTimeOfDay(uint64_t seconds)
+    {
+        uint64_t sinceMidnight = seconds <= SESSION_SECONDS / 2 ? 9 * 3600 + 30 * 60 + seconds : 13 * 3600 + seconds - SESSION_SECONDS / 2;
+        return sinceMidnight / 3600 * 10000 + sinceMidnight / 60 % 60 * 100 + sinceMidnight % 60;
+    }
+
+    bool WriteBarsFile(const std::string& filePath, const Bars& bars, std::string& error)
+    {
+        std::error_code errorCode;
+        std::filesystem::create_directories(std::filesystem::path(filePath).parent_path(), errorCode);
+        if (errorCode)
+        {
+            error = "Failed to create directory for " + filePath + ": " + errorCode.message();
+            return false;
+        }
+        return StockData::WriteBars(filePath, bars, error);
+    }
+}
+
+std::string StockData::SyntheticDataset::GetFilePath(const std::string &symbol, DataFrequency frequency, uint64_t date) const
+{
+    switch (frequency)
+    {
+        case DataFrequency::Bar1m:
+            return root + "/1m/" + symbol + '/' + std::to_string(date) + ".1m.bars";
+        case DataFrequency::Bar1d:
+            return root + "/1d/" + symbol + ".1d.bars";
+        case DataFrequency::Tick:
+            return root + "/tick/" + symbol + "." + std::to_string(date) + ".ticks";
+        default:
+            return std::string();
+    }
+}
+
+void StockData::GetWeekdays(uint64_t date, size_t count, std::vector<uint64_t> &dates)
+{
+    using namespace std::chrono;
+    dates.clear();
+    dates.reserve(count);
+    sys_days current = year_month_day{year(int(date / 10000)), month(unsigned(date / 100 % 100)), day(unsigned(date % 100))};
+    for (; dates.size() < count; current += days(1))
+    {
+        weekday dayOfWeek(current);
+        if (dayOfWeek == Saturday || dayOfWeek == Sunday)
+        {
+            continue;
+        }
+        year_month_day ymd(current);
+        dates.push_back(uint64_t(int(ymd.year())) * 10000 + unsigned(ymd.month()) * 100 + unsigned(ymd.day()));
+    }
+}
+
+void StockData::GenerateDailyBars(const std::string &symbol, const std::vector<uint64_t> &dates, uint64_t seed, Bars &bars)
+{
+    Random random = MakeRandom(seed, symbol, 0, 0);
+    bars.symbol = symbol;
+    bars.frequency = DataFrequency::Bar1d;
+    bars.data.clear();
+    bars.data.reserve(dates.size());
+
+    double close = RoundPrice(5.0 + 95.0 * random.Uniform());
+    for (uint64_t date : dates)
+    {
+        Bar bar = MakeBar(random, date, close, close, 0.02, 100000.0);
+        close = bar.close;
+        bars.data.push_back(bar);
+    }
+}
+
+void StockData::GenerateMinuteBars(const std::string &symbol, uint64_t date, uint64_t seed, Bars &bars)
+{
+    Random random = MakeRandom(seed, symbol, date, 1);
+    bars.symbol = symbol;
+    bars.frequency = DataFrequency::Bar1m;
+    bars.data.clear();
+    bars.data.reserve(SESSION_MINUTES);
+
+    double previousClose = RoundPrice(5.0 + 95.0 * random.Uniform());
+    double close = previousClose;
+    for (size_t i = 0; i < SESSION_MINUTES; ++i)
+    {
+        Bar bar = MakeBar(random, GetSessionMinuteLabel(i), close, previousClose, 0.0015, 2000.0);
+        close = bar.close;
+        bars.data.push_back(bar);
+    }
+}
+
+void StockData::GenerateTicks(const std::string &symbol, uint64_t date, size_t count, uint64_t seed, Ticks &ticks)
+{
+    Random random = MakeRandom(seed, symbol, date, 2);
+    memset(ticks.symbol, 0, SYMBOL_SIZE);
+    memcpy(ticks.symbol, symbol.data(), std::min(symbol.size(), SYMBOL_SIZE - 1));
+    ticks.date = date;
+    ticks.tickCount = count;
+    ticks.Allocate(count);
+
+    double previousClose = RoundPrice(5.0 + 95.0 * random.Uniform());
+    double limitUp = RoundPrice(previousClose * (1.0 + LIMIT_RATIO));
+    double limitDown = RoundPrice(previousClose * (1.0 - LIMIT_RATIO));
+    double price = previousClose;
+    double dayVolume = 0.0;
+    double dayAmount = 0.0;
+    for (size_t i = 0; i < count; ++i)
+    {
+        Tick& tick = ticks.data[i];
+        tick.time = GetSessionTimeOfDay((i + 1) * SESSION_SECONDS / count); // the last snapshot is the close at 15:00:00
+        bool traded = random.Uniform() < 0.8;
+        if (traded)
+        {
+            price = std::clamp(RoundPrice(price * (1.0 + 0.0008 * random.Normal())), limitDown, limitUp);
+        }
+        tick.price = price;
+        tick.tickVolume = traded ? random.Lots(50.0) : 0.0;
+        tick.tickAmount = tick.tickVolume * price;
+        tick.transactionCount = traded ? 1.0 + std::floor(random.Uniform() * 20.0) : 0.0;
+        dayVolume += tick.tickVolume;
+        dayAmount += tick.tickAmount;
+        tick.dayVolume = dayVolume;
+        tick.dayAmount = dayAmount;
+        for (size_t level = 0; level < 5; ++level)
+        {
+            tick.askPrices[level] = RoundPrice(price + PRICE_STEP * (level + 1));
+            tick.bidPrices[level] = RoundPrice(price - PRICE_STEP * level);
+            tick.askVolumes[level] = random.Lots(200.0);
+            tick.bidVolumes[level] = random.Lots(200.0);
+        }
+    }
+}
+
+bool StockData::WriteSyntheticData(const std::string &root, const SyntheticDataOptions &options, SyntheticDataset &dataset, std::string &error)
+{
+    dataset.root = root;
+    dataset.symbols.clear();
+    for (size_t i = 0; i < options.symbolCount; ++i)
+    {
+        dataset.symbols.push_back(std::to_string(600000 + i));
+    }
+    GetWeekdays(options.firstDate, std::max(options.dailyBarCount, options.dayCount), dataset.dailyDates);
+    dataset.dates.assign(dataset.dailyDates.begin(), dataset.dailyDates.begin() + options.dayCount);
+    dataset.dailyDates.resize(options.dailyBarCount);
+
+    std::error_code errorCode;
+    std::filesystem::create_directories(root + "/tick", errorCode);
+    if (errorCode)
+    {
+        error = "Failed to create directory " + root + "/tick: " + errorCode.message();
+        return false;
+    }
+
+    Bars bars;
+    Ticks ticks;
+    for (const std::string& symbol : dataset.symbols)
+    {
+        GenerateDailyBars(symbol, dataset.dailyDates, options.seed, bars);
+        if (!WriteBarsFile(dataset.GetFilePath(symbol, DataFrequency::Bar1d), bars, error))
+        {
+            return false;
+        }
+        for (uint64_t date : dataset.dates)
+        {
+            GenerateMinuteBars(symbol, date, options.seed, bars);
+            if (!WriteBarsFile(dataset.GetFilePath(symbol, DataFrequency::Bar1m, date), bars, error))
+            {
+                return false;
+            }
+            GenerateTicks(symbol, date, options.ticksPerDay, options.seed, ticks);
+            if (!WriteTicks(dataset.GetFilePath(symbol, DataFrequency::Tick, date), ticks, error))
+            {
+                return false;
+            }
+        }
+    }
+    return true;
+}
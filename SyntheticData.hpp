@@ -0,0 +1,62 @@
+#pragma once
+#include <cstddef>
+#include <cstdint>
+#include <string>
+#include <vector>
+
+#include "StockData.hpp"
+
+namespace StockData
+{
+    // Deterministic synthetic market data in the binary layouts of the real files, for benchmarks and experiments
+    // that should not depend on the data directory. Prices follow a random walk on a 0.01 grid within the ±10% daily limit,
+    // volumes are round lots of 100 shares. The same seed always gives the same files: the generator draws its own
+    // random numbers instead of using std distributions, whose output differs between standard libraries
+
+    struct SyntheticDataOptions
+    {
+        uint64_t seed = 1;
+        size_t symbolCount = 16;       // symbols 600000, 600001, ...
+        uint64_t firstDate = 20240102; // first trading day, weekends are skipped
+        size_t dailyBarCount = 2500;   // bars of each .1d.bars file, starting on firstDate
+        size_t dayCount = 5;           // days of .1m.bars and tick files, starting on firstDate
+        size_t ticksPerDay = 4800;     // one snapshot every 3 seconds of the two sessions
+    };
+
+    /// @brief Files written by WriteSyntheticData, under a root directory laid out like the data directories:
+    /// 1d/<symbol>.1d.bars, 1m/<symbol>/<date>.1m.bars and tick/<symbol>.<date>.ticks
+    struct SyntheticDataset
+    {
+        std::string root;
+        std::vector<std::string> symbols;
+        std::vector<uint64_t> dailyDates; // dates of the daily bars
+        std::vector<uint64_t> dates;      // dates of the 1m bars and ticks
+
+        /// @brief Same as GetFilePath, under the root of the dataset
+        std::string GetFilePath(const std::string& symbol, DataFrequency frequency, uint64_t date = 0) const;
+    };
+
+    /// @brief Trading days (weekdays) starting from a date (included)
+    /// @param date YYYYMMDD
+    void GetWeekdays(uint64_t date, size_t count, std::vector<uint64_t>& dates);
+
+    /// @brief Daily bars of a symbol, timed YYYYMMDD
+    /// @param seed bars of different symbols or seeds are independent
+    void GenerateDailyBars(const std::string& symbol, const std::vector<uint64_t>& dates, uint64_t seed, Bars& bars);
+
+    /// @brief The SESSION_MINUTES one-minute bars of a day, timed like the bars of .1m.bars files: HHMMSS of the end of
+    /// the minute, without the date (see GetSessionMinuteLabel)
+    /// @param date picks the random stream of the day, the bar times do not carry it
+    void GenerateMinuteBars(const std::string& symbol, uint64_t date, uint64_t seed, Bars& bars);
+
+    /// @brief Snapshots of a day spread evenly over the two sessions, with a five-level book around the price
+    /// and dayVolume, dayAmount accumulating the tick volumes and amounts
+    void GenerateTicks(const std::string& symbol, uint64_t date, size_t count, uint64_t seed, Ticks& ticks);
+
+    /// @brief Generate and write every file of a dataset
+    /// @param root created if it does not exist, existing files are overwritten
+    /// @param dataset set to the dataset written
+    /// @param error set to the reason of the failure, if any
+    /// @return true if every file was written, false otherwise
+    bool WriteSyntheticData(const std::string& root, const SyntheticDataOptions& options, SyntheticDataset& dataset, std::string& error);
+}
@@ -0,0 +1,180 @@
+#include "TickColumns.hpp"
+#include "TickStream.hpp"
+#include <new>
+
+namespace
+{
+    constexpr size_t LOAD_CHUNK_TICKS = 4096;
+
+    std::byte* AllocateColumns(size_t bytes)
+    {
+        return static_cast<std::byte*>(::operator new(bytes, std::align_val_t(StockData::TickColumns::COLUMN_ALIGNMENT)));
+    }
+
+    void FreeColumns(std::byte* storage)
+    {
+        if (storage != nullptr)
+        {
+            ::operator delete(storage, std::align_val_t(StockData::TickColumns::COLUMN_ALIGNMENT));
+        }
+    }
+}
+
+StockData::TickColumns::TickColumns(const TickColumns &other)
+{
+    *this = other;
+}
+
+StockData::TickColumns::TickColumns(TickColumns &&other) noexcept
+{
+    *this = std::move(other);
+}
+
+StockData::TickColumns &StockData::TickColumns::operator=(const TickColumns &other)
+{
+    if (this != &other)
+    {
+        memcpy(symbol, other.symbol, SYMBOL_SIZE);
+        date = other.date;
+        Resize(other.tickCount);
+        for (size_t column = 0; column < COLUMN_COUNT && tickCount > 0; ++column)
+        {
+            memcpy(storage + column * columnStride, other.storage + column * other.columnStride, tickCount * sizeof(double));
+        }
+    }
+    return *this;
+}
+
+StockData::TickColumns &StockData::TickColumns::operator=(TickColumns &&other) noexcept
+{
+    if (this != &other)
+    {
+        FreeColumns(storage);
+        memcpy(symbol, other.symbol, SYMBOL_SIZE);
+        date = other.date;
+        storage = other.storage;
+        columnStride = other.columnStride;
+        tickCount = other.tickCount;
+        capacity = other.capacity;
+
+        other.storage = nullptr;
+        other.columnStride = 0;
+        other.tickCount = 0;
+        other.capacity = 0;
+    }
+    return *this;
+}
+
+StockData::TickColumns::~TickColumns()
+{
+    FreeColumns(storage);
+}
+
+StockData::TickColumns::TickColumns(const Ticks &ticks)
+{
+    FromTicks(ticks);
+}
+
+void StockData::TickColumns::Resize(size_t count)
+{
+    if (count > capacity)
+    {
+        FreeColumns(storage);
+        columnStride = (count * sizeof(double) + COLUMN_ALIGNMENT - 1) / COLUMN_ALIGNMENT * COLUMN_ALIGNMENT;
+        storage = AllocateColumns(columnStride * COLUMN_COUNT);
+        capacity = columnStride / sizeof(double);
+    }
+    tickCount = count;
+}
+
+void StockData::TickColumns::Clear()
+{
+    memset(symbol, 0, SYMBOL_SIZE);
+    date = 0;
+    tickCount = 0;
+}
+
+StockData::Tick StockData::TickColumns::GetTick(size_t i) const
+{
+    Tick tick;
+    tick.time = Time()[i];
+    tick.price = Price()[i];
+    tick.transactionCount = TransactionCount()[i];
+    tick.tickVolume = TickVolume()[i];
+    tick.tickAmount = TickAmount()[i];
+    tick.dayVolume = DayVolume()[i];
+    tick.dayAmount = DayAmount()[i];
+    for (size_t level = 0; level < BOOK_LEVELS; ++level)
+    {
+        tick.askVolumes[level] = AskVolumes(level)[i];
+        tick.askPrices[level] = AskPrices(level)[i];
+        tick.bidVolumes[level] = BidVolumes(level)[i];
+        tick.bidPrices[level] = BidPrices(level)[i];
+    }
+    return tick;
+}
+
+void StockData::TickColumns::SetTick(size_t i, const Tick &tick)
+{
+    Time()[i] = tick.time;
+    Price()[i] = tick.price;
+    TransactionCount()[i] = tick.transactionCount;
+    TickVolume()[i] = tick.tickVolume;
+    TickAmount()[i] = tick.tickAmount;
+    DayVolume()[i] = tick.dayVolume;
+    DayAmount()[i] = tick.dayAmount;
+    for (size_t level = 0; level < BOOK_LEVELS; ++level)
+    {
+        AskVolumes(level)[i] = tick.askVolumes[level];
+        AskPrices(level)[i] = tick.askPrices[level];
+        BidVolumes(level)[i] = tick.bidVolumes[level];
+        BidPrices(level)[i] = tick.bidPrices[level];
+    }
+}
+
+void StockData::TickColumns::FromTicks(const Ticks &ticks)
+{
+    memcpy(symbol, ticks.symbol, SYMBOL_SIZE);
+    date = ticks.date;
+    Resize(ticks.tickCount);
+    for (size_t i = 0; i < tickCount; ++i)
+    {
+        SetTick(i, ticks.data[i]);
+    }
+}
+
+void StockData::TickColumns::ToTicks(Ticks &ticks) const
+{
+    memcpy(ticks.symbol, symbol, SYMBOL_SIZE);
+    ticks.date = date;
+    ticks.tickCount = tickCount;
+    ticks.Allocate(tickCount);
+    for (size_t i = 0; i < tickCount; ++i)
+    {
+        ticks.data[i] = GetTick(i);
+    }
+}
+
+bool StockData::TickColumns::Load(const std::string &filePath)
+{
+    TickStream stream(LOAD_CHUNK_TICKS);
+    if (!stream.Open(filePath))
+    {
+        return false;
+    }
+
+    memcpy(symbol, stream.symbol, SYMBOL_SIZE);
+    date = stream.date;
+    Resize(stream.Remaining());
+
+    size_t loaded = 0;
+    for (auto batch = stream.NextBatch(); !batch.empty(); batch = stream.NextBatch())
+    {
+        for (const Tick& tick : batch)
+        {
+            SetTick(loaded++, tick);
+        }
+    }
+    tickCount = loaded;
+    return true;
+}
@@ -0,0 +1,117 @@
+#pragma once
+#include <cstddef>
+#include <cstdint>
+#include <string>
+
+#include "StockData.hpp"
+
+namespace StockData
+{
+    constexpr size_t BOOK_LEVELS = 5;
+
+    /// @brief Columns of a TickColumns, one per Tick field and per book level
+    enum class TickField
+    {
+        Time = 0,
+        Price,
+        TransactionCount,
+        TickVolume,
+        TickAmount,
+        DayVolume,
+        DayAmount,
+        AskVolumes,
+        AskPrices = AskVolumes + BOOK_LEVELS,
+        BidVolumes = AskPrices + BOOK_LEVELS,
+        BidPrices = BidVolumes + BOOK_LEVELS,
+        Count = BidPrices + BOOK_LEVELS
+    };
+
+    /// @brief Ticks of a symbol-day stored column by column (SoA), each column a 64 bytes aligned contiguous array
+    struct TickColumns
+    {
+        static constexpr size_t COLUMN_ALIGNMENT = 64;
+        static constexpr size_t COLUMN_COUNT = static_cast<size_t>(TickField::Count);
+
+        char symbol[SYMBOL_SIZE] = {};
+        uint64_t date = 0;
+
+        TickColumns() = default;
+        TickColumns(const TickColumns& other);
+        TickColumns(TickColumns&& other) noexcept;
+        TickColumns& operator=(const TickColumns& other);
+        TickColumns& operator=(TickColumns&& other) noexcept;
+        ~TickColumns();
+
+        /// @brief Build the columns from ticks read by ReadTicks
+        explicit TickColumns(const Ticks& ticks);
+
+        size_t size() const { return tickCount; }
+        bool empty() const { return tickCount == 0; }
+
+        /// @brief Resize to a number of ticks, existing values are not preserved when the capacity grows
+        void Resize(size_t count);
+
+        void Clear();
+
+        const uint64_t* Time() const { return reinterpret_cast<const uint64_t*>(storage); }
+        uint64_t* Time() { return reinterpret_cast<uint64_t*>(storage); }
+
+        const double* Price() const { return Column(TickField::Price); }
+        double* Price() { return Column(TickField::Price); }
+        const double* TransactionCount() const { return Column(TickField::TransactionCount); }
+        double* TransactionCount() { return Column(TickField::TransactionCount); }
+        const double* TickVolume() const { return Column(TickField::TickVolume); }
+        double* TickVolume() { return Column(TickField::TickVolume); }
+        const double* TickAmount() const { return Column(TickField::TickAmount); }
+        double* TickAmount() { return Column(TickField::TickAmount); }
+        const double* DayVolume() const { return Column(TickField::DayVolume); }
+        double* DayVolume() { return Column(TickField::DayVolume); }
+        const double* DayAmount() const { return Column(TickField::DayAmount); }
+        double* DayAmount() { return Column(TickField::DayAmount); }
+
+        /// @param level 0 for the best price, up to BOOK_LEVELS - 1
+        const double* AskVolumes(size_t level) const { return Column(TickField::AskVolumes, level); }
+        double* AskVolumes(size_t level) { return Column(TickField::AskVolumes, level); }
+        const double* AskPrices(size_t level) const { return Column(TickField::AskPrices, level); }
+        double* AskPrices(size_t level) { return Column(TickField::AskPrices, level); }
+        const double* BidVolumes(size_t level) const { return Column(TickField::BidVolumes, level); }
+        double* BidVolumes(size_t level) { return Column(TickField::BidVolumes, level); }
+        const double* BidPrices(size_t level) const { return Column(TickField::BidPrices, level); }
+        double* BidPrices(size_t level) { return Column(TickField::BidPrices, level); }
+
+        /// @brief Raw access to a column, Time is stored as uint64_t and everything else as double
+        /// @param field the column, or the first level of a book column
+        /// @param level offset from field, for the book columns
+        const double* Column(TickField field, size_t level = 0) const
+        {
+            return reinterpret_cast<const double*>(storage + (static_cast<size_t>(field) + level) * columnStride);
+        }
+        double* Column(TickField field, size_t level = 0)
+        {
+            return reinterpret_cast<double*>(storage + (static_cast<size_t>(field) + level) * columnStride);
+        }
+
+        /// @brief Gather a tick back into the AoS layout
+        Tick GetTick(size_t i) const;
+
+        /// @brief Scatter an AoS tick into the columns
+        void SetTick(size_t i, const Tick& tick);
+
+        /// @brief Replace the content with ticks read by ReadTicks
+        void FromTicks(const Ticks& ticks);
+
+        /// @brief Convert back to the AoS layout, into an array owned by ticks
+        void ToTicks(Ticks& ticks) const;
+
+        /// @brief Read a tick file straight into the columns, without materialising the whole day as Tick
+        /// @param filePath path of the tick file
+        /// @return true if the file was read, false otherwise
+        bool Load(const std::string& filePath);
+
+    private:
+        std::byte* storage = nullptr;
+        size_t columnStride = 0; // bytes between two columns, a multiple of COLUMN_ALIGNMENT
+        size_t tickCount = 0;
+        size_t capacity = 0;
+    };
+}
@@ -0,0 +1,150 @@
+#include "TickReplay.hpp"
+#include <algorithm>
+#include <bit>
+#include <limits>
+
+StockData::TickReplay::TickReplay(size_t ticksPerChunk)
+    : chunkTicks(std::max<size_t>(ticksPerChunk, 1))
+{}
+
+bool StockData::TickReplay::AddSource(const std::string &filePath, std::string &error)
+{
+    if (built)
+    {
+        error = "Cannot add a source after the replay started: " + filePath;
+        return false;
+    }
+
+    Source& source = sources.emplace_back(chunkTicks);
+    if (!source.stream.Open(filePath))
+    {
+        error = "Failed to open file: " + filePath;
+        sources.pop_back();
+        return false;
+    }
+    if (sources.size() > 1 && source.stream.date != date)
+    {
+        error = "Tick file of " + std::to_string(source.stream.date) + " in a replay of " + std::to_string(date) + ": " + filePath;
+        sources.pop_back();
+        return false;
+    }
+    date = source.stream.date;
+    return true;
+}
+
+void StockData::TickReplay::AddDay(const std::vector<std::string> &symbols, uint64_t day, std::vector<LoadFailure> &failures)
+{
+    failures.clear();
+    sources.reserve(sources.size() + symbols.size());
+    for (size_t i = 0; i < symbols.size(); ++i)
+    {
+        std::string filePath = GetFilePath(symbols[i], DataFrequency::Tick, day);
+        std::string error;
+        if (!AddSource(filePath, error))
+        {
+            failures.push_back(LoadFailure{i, filePath, error});
+        }
+    }
+}
+
+void StockData::TickReplay::Refill(Source &source)
+{
+    // the times are copied out while the chunk is still in cache, so the tournament never touches the ticks themselves
+    source.chunk = source.stream.NextBatch();
+    source.position = 0;
+    source.chunkTimes.resize(source.chunk.size());
+    for (size_t i = 0; i < source.chunk.size(); ++i)
+    {
+        source.chunkTimes[i] = source.chunk[i].time;
+    }
+}
+
+void StockData::TickReplay::Build()
+{
+    built = true;
+    leafCount = std::bit_ceil(std::max<size_t>(sources.size(), 1));
+    indexBits = std::bit_width(leafCount - 1);
+    exhaustedTime = std::numeric_limits<uint64_t>::max() >> indexBits;
+
+    // play the tournament bottom up: every inner node keeps the loser of its match and passes the winner up
+    std::vector<uint64_t> winners(2 * leafCount);
+    for (size_t i = 0; i < leafCount; ++i)
+    {
+        winners[leafCount + i] = MakeExhaustedKey(i);
+        if (i < sources.size())
+        {
+            Source& source = sources[i];
+            Refill(source);
+            if (!source.chunk.empty())
+            {
+                winners[leafCount + i] = MakeKey(source.chunkTimes[0], i);
+            }
+        }
+    }
+    losers.assign(leafCount, 0);
+    for (size_t node = leafCount - 1; node >= 1; --node)
+    {
+        winners[node] = std::min(winners[2 * node], winners[2 * node + 1]);
+        losers[node] = std::max(winners[2 * node], winners[2 * node + 1]);
+    }
+    winnerKey = winners[1];
+}
+
+void StockData::TickReplay::Advance(size_t sourceIndex)
+{
+    Source& source = sources[sourceIndex];
+    if (++source.position == source.chunk.size())
+    {
+        Refill(source);
+    }
+    if (source.position == source.chunk.size())
+    {
+        winnerKey = MakeExhaustedKey(sourceIndex);
+    }
+    else
+    {
+        winnerKey = MakeKey(source.chunkTimes[source.position], sourceIndex);
+
+        // with many sources the next tick of this one is usually out of cache by the time it wins, start loading it now
+        const char* next = reinterpret_cast<const char*>(&source.chunk[source.position]);
+        for (size_t offset = 0; offset < sizeof(Tick); offset += 64)
+        {
+            __builtin_prefetch(next + offset);
+        }
+    }
+
+    // only the matches on the path from this leaf to the root can change. The loads of a level do not depend on
+    // the outcome of the level below and min/max compile to conditional moves, the outcomes being close to random
+    uint64_t key = winnerKey;
+    for (size_t node = (leafCount + sourceIndex) / 2; node >= 1; node /= 2)
+    {
+        uint64_t loserKey = losers[node];
+        losers[node] = std::max(key, loserKey);
+        key = std::min(key, loserKey);
+    }
+    winnerKey = key;
+}
+
+bool StockData::TickReplay::Next(ReplayEvent &event)
+{
+    if (!built)
+    {
+        Build();
+    }
+    else if (advancePending)
+    {
+        Advance(Winner());
+    }
+
+    if ((winnerKey >> indexBits) == exhaustedTime)
+    {
+        advancePending = false;
+        return false;
+    }
+    size_t winner = Winner();
+    const Source& source = sources[winner];
+    event.sourceIndex = winner;
+    event.tick = &source.chunk[source.position];
+    advancePending = true;
+    return true;
+}
@@ -0,0 +1,102 @@
+#pragma once
+#include <cstddef>
+#include <algorithm>
+#include <cstdint>
+#include <span>
+#include <string>
+#include <vector>
+
+#include "StockData.hpp"
+#include "TickStream.hpp"
+#include "Universe.hpp"
+
+namespace StockData
+{
+    /// @brief A tick of the merged replay, see TickReplay::Next
+    struct ReplayEvent
+    {
+        size_t sourceIndex; // index of the source in the order they were added
+        const Tick* tick;   // valid until the next call to Next
+    };
+
+    /// @brief Merges the tick files of many symbols of one day into a single stream ordered by Tick::time,
+    /// ticks with the same time come in the order their sources were added.
+    /// Each source is read in chunks through a TickStream, so memory is bounded by sources * chunkTicks ticks,
+    /// and the next tick is picked with a loser tree, log2(sources) comparisons per tick.
+    /// Every source keeps its file open, so thousands of symbols may need a higher open file limit (ulimit -n)
+    struct TickReplay
+    {
+        static constexpr size_t DEFAULT_CHUNK_TICKS = 256;
+
+        /// @param chunkTicks ticks read at once from each source
+        explicit TickReplay(size_t chunkTicks = DEFAULT_CHUNK_TICKS);
+
+        TickReplay(const TickReplay&) = delete;
+        TickReplay& operator=(const TickReplay&) = delete;
+
+        /// @brief Add a tick file to the replay. Can be called until the first Next
+        /// @return false if the file could not be opened or is of another date than the sources added before
+        bool AddSource(const std::string& filePath, std::string& error);
+
+        /// @brief Add the tick files of a day, the symbols whose file could not be added are recorded in failures
+        /// @param failures symbolIndex is the index in symbols, gets cleared in this function
+        void AddDay(const std::vector<std::string>& symbols, uint64_t date, std::vector<LoadFailure>& failures);
+
+        size_t SourceCount() const { return sources.size(); }
+        const char* Symbol(size_t sourceIndex) const { return sources[sourceIndex].stream.symbol; }
+
+        /// @return date of the sources, 0 if none was added
+        uint64_t Date() const { return date; }
+
+        /// @brief Next tick in time order
+        /// @return false once every source is exhausted
+        bool Next(ReplayEvent& event);
+
+        /// @brief Call function(event) for every remaining tick, in time order
+        /// @return number of ticks replayed
+        template <typename Function>
+        size_t Run(Function&& function)
+        {
+            size_t count = 0;
+            ReplayEvent event;
+            while (Next(event))
+            {
+                function(event);
+                ++count;
+            }
+            return count;
+        }
+
+    private:
+        struct Source
+        {
+            TickStream stream;
+            std::span<const Tick> chunk;
+            std::vector<uint64_t> chunkTimes; // time of each tick of the chunk
+            size_t position = 0;
+
+            explicit Source(size_t chunkTicks) : stream(chunkTicks) {}
+        };
+
+        /// @brief Tournament key of a leaf: the time of its next tick in the high bits, its index in the low bits,
+        /// so a single integer comparison orders by time and then by source
+        uint64_t MakeKey(uint64_t time, size_t leafIndex) const { return (std::min(time, exhaustedTime - 1) << indexBits) | leafIndex; }
+        uint64_t MakeExhaustedKey(size_t leafIndex) const { return (exhaustedTime << indexBits) | leafIndex; }
+        size_t Winner() const { return winnerKey & ((uint64_t(1) << indexBits) - 1); }
+
+        void Refill(Source& source);
+        void Build();
+        void Advance(size_t sourceIndex);
+
+        size_t chunkTicks;
+        uint64_t date = 0;
+        std::vector<Source> sources;
+        std::vector<uint64_t> losers;  // key of the loser of each inner node, 1 to leafCount - 1
+        size_t leafCount = 0;
+        size_t indexBits = 0;
+        uint64_t exhaustedTime = 0;    // time in the key of exhausted leaves, larger times are clamped below it
+        uint64_t winnerKey = 0;
+        bool built = false;
+        bool advancePending = false;   // the winner's tick was handed out, move past it on the next call
+    };
+}
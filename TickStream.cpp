@@ -0,0 +1,74 @@
+#include "TickStream.hpp"
+#include <algorithm>
+#include <iostream>
+
+StockData::TickStream::TickStream(size_t chunkTicks)
+    : buffer(std::max<size_t>(chunkTicks, 1))
+{}
+
+bool StockData::TickStream::Open(const std::string &filePath)
+{
+    Close();
+
+    file.open(filePath, std::ios::binary);
+    if (!file.is_open())
+    {
+        std::cerr << "Failed to open file: " << filePath << '\n';
+        return false;
+    }
+
+    file.seekg(0, std::ios::end);
+    size_t fileSize = file.tellg();
+    file.seekg(0, std::ios::beg);
+    if (fileSize < StockData::TICK_INFO_SIZE)
+    {
+        std::cerr << "Invalid tick file: " << filePath << '\n';
+        Close();
+        return false;
+    }
+    size_t dataCount = (fileSize - StockData::TICK_INFO_SIZE) / sizeof(StockData::Tick);
+
+    file.read(symbol, StockData::SYMBOL_SIZE);
+    file.read((char*)&date, sizeof(uint64_t));
+    file.read((char*)&tickCount, sizeof(size_t));
+    if (tickCount != dataCount)
+    {
+        std::cerr << "Data count mismatch: " << tickCount << " != " << dataCount << '\n';
+    }
+
+    remaining = dataCount;
+    return true;
+}
+
+bool StockData::TickStream::Open(const std::string &stockSymbol, uint64_t tickDate)
+{
+    std::string filePath = GetFilePath(stockSymbol, DataFrequency::Tick, tickDate);
+    return !filePath.empty() && Open(filePath);
+}
+
+void StockData::TickStream::Close()
+{
+    if (file.is_open())
+    {
+        file.close();
+    }
+    file.clear();
+    memset(symbol, 0, SYMBOL_SIZE);
+    date = 0;
+    tickCount = 0;
+    remaining = 0;
+}
+
+std::span<const StockData::Tick> StockData::TickStream::NextBatch()
+{
+    size_t count = std::min(remaining, buffer.size());
+    if (count == 0)
+    {
+        return {};
+    }
+
+    file.read((char*)buffer.data(), count * sizeof(StockData::Tick));
+    size_t readCount = file.gcount() / sizeof(StockData::Tick);
+    remaining = readCount == count ? remaining - count : 0;
+    return std::span<const Tick>(buffer.data(), readCount);
+}
@@ -0,0 +1,49 @@
+#pragma once
+#include <cstddef>
+#include <cstdint>
+#include <fstream>
+#include <span>
+#include <string>
+#include <vector>
+
+#include "StockData.hpp"
+
+namespace StockData
+{
+    /// @brief Reads a tick file in fixed-size chunks into a reusable buffer,
+    /// so memory does not depend on how many ticks the day has
+    struct TickStream
+    {
+        static constexpr size_t DEFAULT_CHUNK_TICKS = 4096;
+
+        char symbol[SYMBOL_SIZE] = {};
+        uint64_t date = 0;
+        size_t tickCount = 0; // number of ticks in the file
+
+        /// @param chunkTicks maximum number of ticks returned by one NextBatch
+        explicit TickStream(size_t chunkTicks = DEFAULT_CHUNK_TICKS);
+
+        /// @brief Open a tick file and read its header
+        /// @return true if the file was opened, false otherwise
+        bool Open(const std::string& filePath);
+
+        /// @brief Open the tick file of a symbol-day, see GetFilePath
+        bool Open(const std::string& stockSymbol, uint64_t tickDate);
+
+        void Close();
+
+        bool IsOpen() const { return file.is_open(); }
+
+        /// @brief Number of ticks not returned yet
+        size_t Remaining() const { return remaining; }
+
+        /// @brief Read the next chunk of ticks. The span is valid until the next call
+        /// @return the ticks read, empty once the file is exhausted or on a read error
+        std::span<const Tick> NextBatch();
+
+    private:
+        std::ifstream file;
+        std::vector<Tick> buffer;
+        size_t remaining = 0;
+    };
+}
@@ -0,0 +1,103 @@
+#include "Universe.hpp"
+#include "Parallel.hpp"
+#include <algorithm>
+#include <utility>
+
+namespace
+{
+    using StockData::Bar;
+    using StockData::Bars;
+    using StockData::DateRange;
+    using StockData::LoadFailure;
+
+    void TrimToRange(Bars& bars, const DateRange& dateRange)
+    {
+        auto first = std::lower_bound(bars.data.begin(), bars.data.end(), dateRange.from,
+            [](const Bar& bar, uint64_t date) { return bar.time < date; });
+        auto last = std::upper_bound(first, bars.data.end(), dateRange.to,
+            [](uint64_t date, const Bar& bar) { return date < bar.time; });
+        bars.data.erase(last, bars.data.end());
+        bars.data.erase(bars.data.begin(), first);
+    }
+
+    void LoadDaily(size_t symbolIndex, const std::string& symbol, const DateRange& dateRange, Bars& bars, std::vector<LoadFailure>& failures)
+    {
+        std::string filePath = StockData::GetFilePath(symbol, StockData::DataFrequency::Bar1d);
+        std::string error;
+        if (!StockData::ReadBars(filePath, bars, error))
+        {
+            bars.Clear();
+            failures.push_back(LoadFailure{symbolIndex, filePath, error});
+            return;
+        }
+        TrimToRange(bars, dateRange);
+    }
+
+    void LoadMinutes(size_t symbolIndex, const std::string& symbol, const DateRange& dateRange, Bars& bars, std::vector<LoadFailure>& failures)
+    {
+        std::vector<uint64_t> dates;
+        std::string listError;
+        if (!StockData::ListMinuteBarDates(symbol, dates, listError))
+        {
+            bars.Clear();
+            failures.push_back(LoadFailure{symbolIndex, StockData::DATA_DIR_1M + '/' + symbol, listError});
+            return;
+        }
+        dates.erase(std::remove_if(dates.begin(), dates.end(), [&](uint64_t date) { return !dateRange.Contains(date); }), dates.end());
+
+        bars.Clear();
+        bars.symbol = symbol;
+        bars.frequency = StockData::DataFrequency::Bar1m;
+
+        Bars dayBars;
+        for (uint64_t date : dates)
+        {
+            std::string filePath = StockData::GetFilePath(symbol, StockData::DataFrequency::Bar1m, date);
+            std::string error;
+            if (!StockData::ReadBars(filePath, dayBars, error))
+            {
+                failures.push_back(LoadFailure{symbolIndex, filePath, error});
+                continue;
+            }
+            if (bars.data.empty())
+            {
+                bars.symbol = dayBars.symbol;
+            }
+            bars.data.insert(bars.data.end(), dayBars.data.begin(), dayBars.data.end());
+        }
+    }
+}
+
+void StockData::LoadUniverse(const std::vector<std::string> &symbols, DataFrequency frequency, const DateRange &dateRange, size_t threads, Universe &universe)
+{
+    universe.Clear();
+    universe.frequency = frequency;
+    universe.symbols = symbols;
+    universe.bars.resize(symbols.size());
+    for (size_t i = 0; i < symbols.size(); ++i)
+    {
+        universe.symbolIndices.emplace(symbols[i], i);
+    }
+
+    std::vector<std::vector<LoadFailure>> symbolFailures(symbols.size());
+    ParallelFor(symbols.size(), threads, [&](size_t i)
+    {
+        switch (frequency)
+        {
+            case DataFrequency::Bar1d:
+                LoadDaily(i, symbols[i], dateRange, universe.bars[i], symbolFailures[i]);
+                break;
+            case DataFrequency::Bar1m:
+                LoadMinutes(i, symbols[i], dateRange, universe.bars[i], symbolFailures[i]);
+                break;
+            default:
+                symbolFailures[i].push_back(LoadFailure{i, std::string(), "Unsupported frequency"});
+                break;
+        }
+    });
+
+    for (auto& failures : symbolFailures)
+    {
+        std::move(failures.begin(), failures.end(), std::back_inserter(universe.failures));
+    }
+}
@@ -0,0 +1,68 @@
+#pragma once
+#include <cstddef>
+#include <cstdint>
+#include <limits>
+#include <string>
+#include <unordered_map>
+#include <vector>
+
+#include "StockData.hpp"
+
+namespace StockData
+{
+    /// @brief Inclusive range of dates, e.g. 20240101 to 20241231
+    struct DateRange
+    {
+        uint64_t from = 0;
+        uint64_t to = std::numeric_limits<uint64_t>::max();
+
+        bool Contains(uint64_t date) const { return date >= from && date <= to; }
+    };
+
+    /// @brief A file that could not be loaded by LoadUniverse
+    struct LoadFailure
+    {
+        size_t symbolIndex;
+        std::string filePath;
+        std::string error;
+    };
+
+    /// @brief Bars of a set of symbols, indexed like the symbols they were loaded for
+    struct Universe
+    {
+        DataFrequency frequency = DataFrequency::Undefined;
+        std::vector<std::string> symbols;
+        std::vector<Bars> bars;            // bars[i] belongs to symbols[i], empty if nothing could be loaded
+        std::vector<LoadFailure> failures; // ordered by symbol index
+
+        /// @brief Bars of a symbol
+        /// @return nullptr if the symbol is not part of the universe
+        const Bars* Find(const std::string& symbol) const
+        {
+            auto it = symbolIndices.find(symbol);
+            return it != symbolIndices.end() ? &bars[it->second] : nullptr;
+        }
+
+        void Clear()
+        {
+            frequency = DataFrequency::Undefined;
+            symbols.clear();
+            bars.clear();
+            failures.clear();
+            symbolIndices.clear();
+        }
+
+        std::unordered_map<std::string, size_t> symbolIndices;
+    };
+
+    /// @brief Load the bars of many symbols on a pool of worker threads.
+    /// Bar1d reads one file per symbol and keeps the bars within the range.
+    /// Bar1m reads every <date>.1m.bars within the range from the symbol's directory and concatenates them by date.
+    /// A file that fails is recorded in universe.failures, the rest of the batch carries on
+    /// @param symbols symbols to load, e.g. "600000"
+    /// @param frequency Bar1d or Bar1m
+    /// @param dateRange dates to keep
+    /// @param threads number of worker threads, which also bounds the number of reads in flight, 0 for one per hardware thread
+    /// @param universe the results, gets cleared in this function
+    void LoadUniverse(const std::vector<std::string>& symbols, DataFrequency frequency, const DateRange& dateRange, size_t threads, Universe& universe);
+}
@@ -0,0 +1,293 @@
+// Benchmarks of the loaders and kernels on deterministic synthetic data, see SyntheticData.hpp.
+// Prints one JSON object per operation on stdout, for regression tracking: throughput (items/s, MB/s) and latency percentiles per call.
+// Files are read right after being written, so the loaders are measured with the files in the page cache.
+//
+// Built from the repository root with the include paths of the library, e.g.
+//   g++ -std=c++20 -O2 -I. bench/Benchmark.cpp StockData.cpp Metrics.cpp Aggregation.cpp Normalize.cpp TickStream.cpp SyntheticData.cpp -o stockdata-bench
+//   ./stockdata-bench --symbols 64 --days 10 > results.jsonl
+
+#include "StockData.hpp"
+#include "SyntheticData.hpp"
+#include <chrono>
+#include <cstdio>
+#include <filesystem>
+#include <random>
+#include <string>
+#include <vector>
+
+namespace
+{
+    using StockData::AugmentedBar;
+    using StockData::AugmentedBars;
+    using StockData::Bar;
+    using StockData::Bars;
+    using StockData::DataFrequency;
+    using StockData::LatencyHistogram;
+    using StockData::SyntheticDataOptions;
+    using StockData::SyntheticDataset;
+    using StockData::Ticks;
+
+    constexpr size_t WINDOW_BARS = 60; // bars asked from GetNBarsFromDate
+
+    struct BenchmarkOptions
+    {
+        SyntheticDataOptions data;
+        std::string root;         // empty for a directory in the temp directory, removed at the end unless keep is set
+        size_t repetitions = 3;   // passes over every file, or over every series for the kernels
+        size_t queries = 100000;  // GetNBarsFromDate calls
+        bool keep = false;
+    };
+
+    struct Result
+    {
+        std::string operation;
+        std::string itemName;
+        uint64_t calls = 0;
+        uint64_t items = 0;
+        uint64_t bytes = 0;
+        uint64_t totalNanoseconds = 0;
+        LatencyHistogram latency;
+    };
+
+    template <typename Function>
+    void Time(Result& result, Function&& function)
+    {
+        auto start = std::chrono::steady_clock::now();
+        function();
+        uint64_t nanoseconds = std::chrono::duration_cast<std::chrono::nanoseconds>(std::chrono::steady_clock::now() - start).count();
+        ++result.calls;
+        result.totalNanoseconds += nanoseconds;
+        ++result.latency.counts[LatencyHistogram::GetBucketIndex(nanoseconds)];
+    }
+
+    void Print(const Result& result, uint64_t seed)
+    {
+        double seconds = result.totalNanoseconds * 1e-9;
+        double itemsPerSecond = seconds > 0.0 ? result.items / seconds : 0.0;
+        double megabytesPerSecond = seconds > 0.0 ? result.bytes / seconds / 1e6 : 0.0;
+        printf("{\"operation\":\"%s\",\"seed\":%llu,\"calls\":%llu,\"items\":%llu,\"itemName\":\"%s\",\"bytes\":%llu,\"seconds\":%.6f,"
+               "\"itemsPerSecond\":%.1f,\"megabytesPerSecond\":%.2f,\"p50Nanoseconds\":%llu,\"p90Nanoseconds\":%llu,"
+               "\"p99Nanoseconds\":%llu,\"p999Nanoseconds\":%llu,\"maxNanoseconds\":%llu}\n",
+               result.operation.c_str(), (unsigned long long)seed, (unsigned long long)result.calls, (unsigned long long)result.items,
+               result.itemName.c_str(), (unsigned long long)result.bytes, seconds, itemsPerSecond, megabytesPerSecond,
+               (unsigned long long)result.latency.Percentile(0.5), (unsigned long long)result.latency.Percentile(0.9),
+               (unsigned long long)result.latency.Percentile(0.99), (unsigned long long)result.latency.Percentile(0.999),
+               (unsigned long long)result.latency.Max());
+        fflush(stdout);
+    }
+
+    bool ParseArguments(int argc, char** argv, BenchmarkOptions& options)
+    {
+        for (int i = 1; i < argc; ++i)
+        {
+            std::string argument = argv[i];
+            if (argument == "--keep")
+            {
+                options.keep = true;
+                continue;
+            }
+            if (i + 1 >= argc)
+            {
+                return false;
+            }
+            std::string value = argv[++i];
+            if (argument == "--root")
+            {
+                options.root = value;
+                continue;
+            }
+            if (value.empty() || value.find_first_not_of("0123456789") != std::string::npos)
+            {
+                return false;
+            }
+            if (argument == "--seed")
+            {
+                options.data.seed = std::stoull(value);
+                continue;
+            }
+
+            size_t* target = argument == "--symbols" ? &options.data.symbolCount
+                           : argument == "--days" ? &options.data.dayCount
+                           : argument == "--daily-bars" ? &options.data.dailyBarCount
+                           : argument == "--ticks" ? &options.data.ticksPerDay
+                           : argument == "--repetitions" ? &options.repetitions
+                           : argument == "--queries" ? &options.queries
+                           : nullptr;
+            if (target == nullptr)
+            {
+                return false;
+            }
+            *target = std::stoull(value);
+        }
+        return options.data.symbolCount > 0 && options.data.dailyBarCount > 0;
+    }
+
+    void BenchmarkReadBars(const SyntheticDataset& dataset, const BenchmarkOptions& options, DataFrequency frequency, Result& result)
+    {
+        std::vector<std::string> filePaths;
+        for (const std::string& symbol : dataset.symbols)
+        {
+            if (frequency == DataFrequency::Bar1d)
+            {
+                filePaths.push_back(dataset.GetFilePath(symbol, frequency));
+                continue;
+            }
+            for (uint64_t date : dataset.dates)
+            {
+                filePaths.push_back(dataset.GetFilePath(symbol, frequency, date));
+            }
+        }
+
+        Bars bars;
+        std::string error;
+        for (size_t repetition = 0; repetition < options.repetitions; ++repetition)
+        {
+            for (const std::string& filePath : filePaths)
+            {
+                Time(result, [&]() { StockData::ReadBars(filePath, bars, error); });
+                result.items += bars.data.size();
+                result.bytes += std::filesystem::file_size(filePath);
+            }
+        }
+    }
+
+    void BenchmarkReadTicks(const SyntheticDataset& dataset, const BenchmarkOptions& options, bool useArena, Result& result)
+    {
+        Ticks ticks;
+        StockData::TickArena arena;
+        for (size_t repetition = 0; repetition < options.repetitions; ++repetition)
+        {
+            for (const std::string& symbol : dataset.symbols)
+            {
+                for (uint64_t date : dataset.dates)
+                {
+                    std::string filePath = dataset.GetFilePath(symbol, DataFrequency::Tick, date);
+                    if (useArena)
+                    {
+                        Time(result, [&]() { StockData::ReadTicks(filePath, ticks, arena); });
+                    }
+                    else
+                    {
+                        Time(result, [&]() { StockData::ReadTicks(filePath, ticks); });
+                    }
+                    result.items += ticks.tickCount;
+                    result.bytes += StockData::TICK_INFO_SIZE + ticks.tickCount * sizeof(StockData::Tick);
+                }
+            }
+        }
+    }
+
+    /// @brief Windows of WINDOW_BARS bars up to random dates, the same dates for Bars and AugmentedBars
+    template <typename Series, typename Window>
+    void BenchmarkGetNBarsFromDate(const std::vector<Series>& series, const SyntheticDataset& dataset, const BenchmarkOptions& options, Result& result)
+    {
+        std::mt19937_64 random(options.data.seed);
+        Window window;
+        for (size_t query = 0; query < options.queries; ++query)
+        {
+            const Series& bars = series[random() % series.size()];
+            uint64_t date = dataset.dailyDates[random() % dataset.dailyDates.size()];
+            Time(result, [&]() { bars.GetNBarsFromDate(date, WINDOW_BARS, true, window); });
+            result.items += window.size();
+            result.bytes += window.size() * sizeof(bars.data[0]);
+        }
+    }
+
+    void BenchmarkNormalize(const std::vector<AugmentedBars>& series, const BenchmarkOptions& options, Result& result)
+    {
+        std::vector<AugmentedBars> copies = series;
+        for (size_t repetition = 0; repetition < options.repetitions; ++repetition)
+        {
+            for (AugmentedBars& bars : copies)
+            {
+                Time(result, [&]() { bars.Normalize(); });
+                result.items += bars.data.size();
+                result.bytes += bars.data.size() * sizeof(AugmentedBar);
+            }
+        }
+    }
+
+    void BenchmarkAugmentedBarsFromBuffer(const std::vector<AugmentedBars>& series, const BenchmarkOptions& options, Result& result)
+    {
+        std::vector<std::vector<char>> buffers(series.size());
+        for (size_t i = 0; i < series.size(); ++i)
+        {
+            StockData::WriteAugmentedBars(series[i], buffers[i]);
+        }
+        for (size_t repetition = 0; repetition < options.repetitions; ++repetition)
+        {
+            for (std::vector<char>& buffer : buffers)
+            {
+                size_t count = 0;
+                Time(result, [&]()
+                {
+                    AugmentedBars bars(buffer.data(), buffer.size());
+                    count = bars.data.size();
+                });
+                result.items += count;
+                result.bytes += buffer.size();
+            }
+        }
+    }
+}
+
+int main(int argc, char** argv)
+{
+    BenchmarkOptions options;
+    if (!ParseArguments(argc, argv, options))
+    {
+        fprintf(stderr, "Usage: %s [--root DIR] [--keep] [--seed N] [--symbols N] [--days N] [--daily-bars N] [--ticks N] [--repetitions N] [--queries N]\n", argv[0]);
+        return 1;
+    }
+    bool temporaryRoot = options.root.empty();
+    if (temporaryRoot)
+    {
+        options.root = (std::filesystem::temp_directory_path() / ("stockdata-bench-" + std::to_string(options.data.seed))).string();
+    }
+
+    SyntheticDataset dataset;
+    std::string error;
+    if (!StockData::WriteSyntheticData(options.root, options.data, dataset, error))
+    {
+        fprintf(stderr, "%s\n", error.c_str());
+        return 1;
+    }
+
+    std::vector<Bars> dailyBars(dataset.symbols.size());
+    std::vector<AugmentedBars> augmentedBars;
+    for (size_t i = 0; i < dataset.symbols.size(); ++i)
+    {
+        StockData::ReadBars(dataset.GetFilePath(dataset.symbols[i], DataFrequency::Bar1d), dailyBars[i], error);
+        augmentedBars.emplace_back(dailyBars[i]);
+    }
+
+    auto run = [&](const char* operation, const char* itemName, auto&& benchmark)
+    {
+        Result result;
+        result.operation = operation;
+        result.itemName = itemName;
+        benchmark(result);
+        Print(result, options.data.seed);
+    };
+    run("ReadBars.1d", "bars", [&](Result& result) { BenchmarkReadBars(dataset, options, DataFrequency::Bar1d, result); });
+    run("ReadBars.1m", "bars", [&](Result& result) { BenchmarkReadBars(dataset, options, DataFrequency::Bar1m, result); });
+    run("ReadTicks", "ticks", [&](Result& result) { BenchmarkReadTicks(dataset, options, false, result); });
+    run("ReadTicks.Arena", "ticks", [&](Result& result) { BenchmarkReadTicks(dataset, options, true, result); });
+    run("Bars.GetNBarsFromDate", "bars", [&](Result& result)
+    {
+        BenchmarkGetNBarsFromDate<Bars, std::vector<const Bar*>>(dailyBars, dataset, options, result);
+    });
+    run("AugmentedBars.GetNBarsFromDate", "bars", [&](Result& result)
+    {
+        BenchmarkGetNBarsFromDate<AugmentedBars, std::vector<AugmentedBar>>(augmentedBars, dataset, options, result);
+    });
+    run("AugmentedBars.Normalize", "bars", [&](Result& result) { BenchmarkNormalize(augmentedBars, options, result); });
+    run("AugmentedBars.FromBuffer", "bars", [&](Result& result) { BenchmarkAugmentedBarsFromBuffer(augmentedBars, options, result); });
+
+    if (temporaryRoot && !options.keep)
+    {
+        std::error_code errorCode;
+        std::filesystem::remove_all(options.root, errorCode);
+    }
+    return 0;
+}